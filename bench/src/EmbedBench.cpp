@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "InputSource.hpp"
+#include "PeachCli.hpp"
+#include "collatz.hpp"
+
+namespace
+{
+// Returns best time of repetitions calls of function
+template <typename FunctionT>
+double measure(std::size_t repetitions, FunctionT function)
+{
+    double bestSeconds = 0;
+    for (std::size_t rep = 0; rep < repetitions; ++rep)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (rep == 0 || elapsed.count() < bestSeconds)
+        {
+            bestSeconds = elapsed.count();
+        }
+    }
+    return bestSeconds;
+}
+} // namespace
+
+// Compares script, which is executed by PeachCli, with the same script, embedded at build time
+// Usage: peach-embed-bench [limit] [repetitions]
+int main(int argc, char **argv)
+{
+    int limit = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::size_t repetitions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+    auto source = peach::cli::InputSource::fromFile(PEACH_COLLATZ_SCRIPT);
+
+    std::string cliResult, embeddedResult;
+    double cliSeconds = measure(repetitions, [&] {
+        peach::cli::PeachCli cli;
+        cli.getScope().declare("limit", limit);
+        std::ostringstream os;
+        cli.executeProgram(source.getText(), os);
+        cliResult = os.str();
+    });
+    double embeddedSeconds = measure(repetitions, [&] {
+        peach::expression::Scope scope;
+        scope.declare("limit", limit);
+        std::ostringstream os;
+        os << peach::embedded::collatz(scope) << std::endl;
+        embeddedResult = os.str();
+    });
+
+    std::cout << "collatz script\n"
+              << "    peach cli:     " << cliSeconds << " s\n"
+              << "    embedded:      " << embeddedSeconds << " s\n"
+              << "    speedup:       " << cliSeconds / embeddedSeconds << '\n';
+    if (cliResult != embeddedResult)
+    {
+        std::cout << "    results differ: " << cliResult << " and " << embeddedResult;
+    }
+}
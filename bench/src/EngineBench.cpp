@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "PeachCli.hpp"
+
+namespace
+{
+// Program with single loop of arithmetic assignments
+std::string generateCountingProgram(std::size_t iterations)
+{
+    return "let i = 0\n"
+           "let s = 0\n"
+           "while i < " + std::to_string(iterations) + "\n"
+           "\ts += i % 7 * 3 - 1\n"
+           "\ti += 1\n"
+           "s\n";
+}
+
+// Program with conditionals in loop, like simple.pch
+std::string generateBranchingProgram(std::size_t iterations)
+{
+    return "let a = " + std::to_string(iterations) + "\n"
+           "let even = 0\n"
+           "let odd = 0\n"
+           "let other = 0\n"
+           "while a != 0\n"
+           "\tif a % 2 == 0\n"
+           "\t\teven += 1\n"
+           "\t\tif even % 3 == 2\n"
+           "\t\t\tother += 2 ** (even % 10)\n"
+           "\telse\n"
+           "\t\todd += 1\n"
+           "\ta -= 1\n"
+           "other + even - odd\n";
+}
+
+// Program with nested loops
+std::string generateNestedProgram(std::size_t iterations)
+{
+    return "let i = 0\n"
+           "let j = 0\n"
+           "let s = 0\n"
+           "while i < " + std::to_string(iterations / 100) + "\n"
+           "\tj = 0\n"
+           "\twhile j < 100\n"
+           "\t\ts = s * 31 + j & 65535\n"
+           "\t\tj += 1\n"
+           "\ti += 1\n"
+           "s\n";
+}
+
+// Executes program with engine repetitions times, returns best time, output is written to result
+double run(const std::string &program, peach::cli::PeachCli::Engine engine, std::size_t repetitions, std::string &result)
+{
+    double bestSeconds = 0;
+    for (std::size_t rep = 0; rep < repetitions; ++rep)
+    {
+        peach::cli::PeachCli cli;
+        cli.setEngine(engine);
+        std::ostringstream os;
+        auto begin = std::chrono::steady_clock::now();
+        cli.executeProgram(std::string_view(program), os);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (rep == 0 || elapsed.count() < bestSeconds)
+        {
+            bestSeconds = elapsed.count();
+        }
+        result = os.str();
+    }
+    return bestSeconds;
+}
+
+// Runs program with all engines, prints their best times
+void measure(const std::string &title, const std::string &program, std::size_t repetitions)
+{
+    std::string treeResult, bytecodeResult, jitResult;
+    double treeSeconds = run(program, peach::cli::PeachCli::Engine::TREE, repetitions, treeResult);
+    double bytecodeSeconds = run(program, peach::cli::PeachCli::Engine::BYTECODE, repetitions, bytecodeResult);
+    double jitSeconds = run(program, peach::cli::PeachCli::Engine::JIT, repetitions, jitResult);
+    std::cout << title << '\n'
+              << "    tree walker:   " << treeSeconds << " s\n"
+              << "    bytecode vm:   " << bytecodeSeconds << " s\n"
+              << "    loop jit:      " << jitSeconds << " s\n"
+              << "    speedup:       " << treeSeconds / bytecodeSeconds << " (vm), " << treeSeconds / jitSeconds << " (jit)\n";
+    if (treeResult != bytecodeResult || treeResult != jitResult)
+    {
+        std::cout << "    results differ: " << treeResult << ", " << bytecodeResult << " and " << jitResult;
+    }
+    std::cout << std::flush;
+}
+} // namespace
+
+// Compares evaluation time of tree walking, bytecode and loop jit engines of PeachCli
+// Usage: peach-engine-bench [iterations] [repetitions]
+int main(int argc, char **argv)
+{
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    std::size_t repetitions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+    measure("counting loop", generateCountingProgram(iterations), repetitions);
+    measure("branching loop", generateBranchingProgram(iterations), repetitions);
+    measure("nested loops", generateNestedProgram(iterations), repetitions);
+}
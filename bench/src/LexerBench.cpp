@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "PeachCli.hpp"
+
+namespace
+{
+// Generates syntactically valid peach program of approximately given size
+std::string generateProgram(std::size_t bytes)
+{
+    std::mt19937 rng(239);
+    auto randomName = [&]() {
+        static const std::string alphabet = "abcdefghijklmnopqrstuvwxyz_";
+        std::string name(1 + rng() % 16, 'a');
+        for (auto &c : name)
+        {
+            c = alphabet[rng() % alphabet.size()];
+        }
+        return name + std::to_string(rng() % 100);
+    };
+    static const char *operators[] = {"+", "-", "*", "/", "%", "==", "!=", "<=", ">=", "<", ">", "&", "|", "**"};
+    static const char *assignments[] = {"=", "+=", "-=", "*=", "|="};
+
+    std::string program;
+    std::size_t depth = 0;
+    while (program.size() < bytes)
+    {
+        std::string line(depth, '\t');
+        switch (rng() % 6)
+        {
+        case 0:
+            line += "let " + randomName() + " = " + std::to_string(rng() % 100000);
+            break;
+        case 1:
+            line += (rng() % 2 ? "if " : "while ") + randomName() + " < " + std::to_string(rng() % 1000);
+            ++depth;
+            break;
+        default:
+            line += randomName() + " " + assignments[rng() % 5] + " (" + randomName() + " " +
+                    operators[rng() % 14] + " " + std::to_string(rng() % 1000) + ") " +
+                    operators[rng() % 14] + " " + randomName();
+            if (depth > 0 && rng() % 3 == 0)
+            {
+                --depth;
+            }
+            break;
+        }
+        program += line + '\n';
+    }
+    return program;
+}
+
+// Generates program of approximately given size with deep indentation, long names and long numbers
+std::string generateLongRunsProgram(std::size_t bytes)
+{
+    std::mt19937 rng(42);
+    std::string program;
+    while (program.size() < bytes)
+    {
+        std::string name = "some_descriptive_variable_name_" + std::to_string(rng() % 1000);
+        program += std::string(rng() % 12, '\t') + name + "    +=    " + std::to_string(rng()) + std::to_string(rng()) + "\n\n";
+    }
+    return program;
+}
+
+// Tokenizes program repetitions times, prints best throughput
+void measure(const std::string &title, const std::string &program, std::size_t repetitions, bool parallel = false)
+{
+    peach::cli::PeachCli cli;
+    double bestSeconds = 0;
+    std::size_t tokensCount = 0;
+    for (std::size_t rep = 0; rep < repetitions; ++rep)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        tokensCount = (parallel ? cli.tokenizeParallel(program) : cli.tokenize(program)).size();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (rep == 0 || elapsed.count() < bestSeconds)
+        {
+            bestSeconds = elapsed.count();
+        }
+    }
+    std::cout << title << '\n'
+              << "    bytes:      " << program.size() << '\n'
+              << "    tokens:     " << tokensCount << '\n'
+              << "    best time:  " << bestSeconds << " s\n"
+              << "    throughput: " << program.size() / bestSeconds / (1 << 20) << " MiB/s" << std::endl;
+}
+} // namespace
+
+// Measures tokenization throughput of PeachCli lexer
+// Usage: peach-lexer-bench [megabytes] [repetitions]
+int main(int argc, char **argv)
+{
+    std::size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    std::size_t repetitions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+    measure("generated program", generateProgram(megabytes << 20), repetitions);
+    measure("long runs program", generateLongRunsProgram(megabytes << 20), repetitions);
+    measure("generated program, parallel", generateProgram(megabytes << 20), repetitions, true);
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cerrno>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PEACH_INPUT_POSIX 1
+#else
+#include <fstream>
+#endif
+
+namespace peach
+{
+namespace cli
+{
+// Bytes of program, which are lexed in place
+// Source is one of:
+//     - memory mapped file
+//     - text, owned by caller, it must outlive source
+//     - text, read from stream or pipe in large blocks
+class InputSource
+{
+public:
+    static constexpr std::size_t BLOCK_SIZE = 1 << 20;
+
+    InputSource() = default;
+
+    InputSource(const InputSource &) = delete;
+    InputSource &operator=(const InputSource &) = delete;
+
+    InputSource(InputSource &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    InputSource &operator=(InputSource &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            bool owned = !other.owned_.empty() && other.text_.data() == other.owned_.data();
+            owned_ = std::move(other.owned_);
+            mapped_ = other.mapped_;
+            text_ = owned ? std::string_view(owned_) : other.text_;
+            other.mapped_ = false;
+            other.text_ = {};
+        }
+        return *this;
+    }
+
+    ~InputSource()
+    {
+        release();
+    }
+
+    // Returns source, which refers to caller's text
+    static InputSource fromView(std::string_view text)
+    {
+        InputSource source;
+        source.text_ = text;
+        return source;
+    }
+
+    // Returns source with text of file at path
+    // Regular files are memory mapped, other ones (pipes, devices) are read in blocks
+    static InputSource fromFile(const std::string &path)
+    {
+#ifdef PEACH_INPUT_POSIX
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("can not open file " + path);
+        }
+        InputSource source;
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        {
+            void *data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                ::madvise(data, info.st_size, MADV_SEQUENTIAL);
+                source.text_ = std::string_view(static_cast<const char *>(data), info.st_size);
+                source.mapped_ = true;
+            }
+        }
+        if (!source.mapped_)
+        {
+            source.readBlocks([fd](char *buffer, std::size_t size) -> std::size_t {
+                ssize_t count;
+                do
+                {
+                    count = ::read(fd, buffer, size);
+                } while (count < 0 && errno == EINTR);
+                return count > 0 ? count : 0;
+            });
+        }
+        ::close(fd);
+        return source;
+#else
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs)
+        {
+            throw std::runtime_error("can not open file " + path);
+        }
+        return fromStream(ifs);
+#endif
+    }
+
+    // Returns source with text, read from stream until its end
+    static InputSource fromStream(std::istream &is)
+    {
+        InputSource source;
+        source.readBlocks([&is](char *buffer, std::size_t size) -> std::size_t {
+            is.read(buffer, size);
+            return is.gcount();
+        });
+        return source;
+    }
+
+    std::string_view getText() const noexcept
+    {
+        return text_;
+    }
+
+private:
+    // Appends blocks, returned by read, to owned text, until read returns nothing
+    template <typename ReadFunc>
+    void readBlocks(ReadFunc read)
+    {
+        std::size_t size = 0;
+        for (;;)
+        {
+            owned_.resize(size + BLOCK_SIZE);
+            std::size_t count = read(owned_.data() + size, BLOCK_SIZE);
+            if (count == 0)
+            {
+                break;
+            }
+            size += count;
+        }
+        owned_.resize(size);
+        text_ = owned_;
+    }
+
+    // Unmaps file, if source is mapped
+    void release() noexcept
+    {
+#ifdef PEACH_INPUT_POSIX
+        if (mapped_)
+        {
+            ::munmap(const_cast<char *>(text_.data()), text_.size());
+        }
+#endif
+        mapped_ = false;
+    }
+
+    std::string_view text_; // bytes of program
+    std::string owned_;     // storage of text, if it was read
+    bool mapped_ = false;   // if text is memory mapped file
+};
+} // namespace cli
+} // namespace peach
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "Finders/NameFinder.hpp"
@@ -8,8 +11,16 @@
 #include "Finders/SingleCharFinder.hpp"
 #include "Finders/LiteralFinder.hpp"
 
+#include "Bytecode.hpp"
+#include "LoopJit.hpp"
 #include "FsmCollection.hpp"
+#include "StaticLexer.hpp"
+#include "TokenStream.hpp"
+#include "InputSource.hpp"
+#include "BoundedQueue.hpp"
+#include "IncrementalProgram.hpp"
 #include "Interpreter.hpp"
+#include "StatementCompiler.hpp"
 
 namespace peach
 {
@@ -19,257 +30,240 @@ namespace cli
 class PeachCli
 {
 public:
+    // Engine, which evaluates interpreted programs
+    enum class Engine
+    {
+        TREE,     // walks tree of expressions
+        BYTECODE, // lowers expressions to bytecode and runs it on virtual machine
+        JIT,      // runs bytecode and compiles its hot loops to native code
+    };
+
+    // Programs of this size or larger are lexed in parallel
+    static constexpr std::size_t PARALLEL_LEXING_SIZE = 16 << 20;
+
+    // Capacity of queues of lines and statements in stream execution
+    static constexpr std::size_t STREAM_QUEUE_CAPACITY = 1024;
+
+    // Operator patterns of lexer, pattern gets operator id of its index
+    static constexpr std::pair<std::string_view, token::tokenCategory_t> OPERATORS[] = {
+        {"&=", token::tokenCategory::ASSIGNMENT},
+        {"&", token::tokenCategory::OPERATOR_BI},
+        {"|=", token::tokenCategory::ASSIGNMENT},
+        {"|", token::tokenCategory::OPERATOR_BI},
+        {"*=", token::tokenCategory::ASSIGNMENT},
+        {"**", token::tokenCategory::OPERATOR_BI},
+        {"*", token::tokenCategory::OPERATOR_BI},
+        {"/=", token::tokenCategory::ASSIGNMENT},
+        {"/", token::tokenCategory::OPERATOR_BI},
+        {"%=", token::tokenCategory::ASSIGNMENT},
+        {"%", token::tokenCategory::OPERATOR_BI},
+        {"+=", token::tokenCategory::ASSIGNMENT},
+        {"+", token::tokenCategory::OPERATOR_BI},
+        {"-=", token::tokenCategory::ASSIGNMENT},
+        {"-", token::tokenCategory::OPERATOR_BI},
+        {"==", token::tokenCategory::OPERATOR_BI},
+        {"=", token::tokenCategory::ASSIGNMENT},
+        {"!=", token::tokenCategory::OPERATOR_BI},
+        {"!", token::tokenCategory::OPERATOR_UN},
+        {">", token::tokenCategory::OPERATOR_BI},
+        {"<", token::tokenCategory::OPERATOR_BI},
+        {">=", token::tokenCategory::OPERATOR_BI},
+        {"<=", token::tokenCategory::OPERATOR_BI},
+    };
+
+    // Lexer tables of peach, built at compile time
+    static constexpr fsm::StaticLexerTables<32, 32> LEXER_TABLES{
+        fsm::makeStaticNameFinder(),
+        fsm::makeStaticNumberFinder(token::tokenCategory::VALUE_FLOATING, '.'),
+        fsm::makeStaticNumberFinder(token::tokenCategory::VALUE_INT),
+        fsm::makeStaticOperatorFinder(OPERATORS),
+        fsm::makeStaticSingleCharFinder({
+            {'\n', token::tokenCategory::SEP_ENDL},
+            {' ', token::tokenCategory::SEP_SPACE},
+            {'\t', token::tokenCategory::SEP_TAB},
+            {'(', token::tokenCategory::BRACKET_OPEN},
+            {')', token::tokenCategory::BRACKET_CLOSE},
+        }),
+    };
+
+    // Reserved keywords of peach, hashed at compile time
+    static constexpr fsm::KeywordTable KEYWORDS{{
+        {"if", token::tokenCategory::COND_IF},
+        {"else", token::tokenCategory::COND_ELSE},
+        {"while", token::tokenCategory::LOOP_WHILE},
+        {"let", token::tokenCategory::DECLARATION},
+    }};
+
     PeachCli()
         : interpreter_(std::vector<token::tokenCategory_t>{
                            token::tokenCategory::SEP_TAB,
                        },
                        {
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return !args[0];
-                               },
-                               "!",
-                               token::tokenCategory::OPERATOR_UN,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   expression::VType res = 1;
-                                   expression::VType deg = args[1];
-                                   expression::VType x = args[0];
-                                   while (deg)
-                                   {
-                                       if (!(deg & 1))
-                                       {
-                                           x *= x;
-                                           deg >>= 1;
-                                       }
-                                       else
-                                       {
-                                           res *= x;
-                                           --deg;
-                                       }
-                                   }
-                                   return res;
-                               },
-                               "**",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] * args[1];
-                               },
-                               "*",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   if (args[1] == 0)
-                                   {
-                                       throw exception::ZeroDivisionError();
-                                   }
-                                   return args[0] / args[1];
-                               },
-                               "/",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] % args[1];
-                               },
-                               "%",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] + args[1];
-                               },
-                               "+",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] - args[1];
-                               },
-                               "-",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] == args[1];
-                               },
-                               "==",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] != args[1];
-                               },
-                               "!=",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] > args[1];
-                               },
-                               ">",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] >= args[1];
-                               },
-                               ">=",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] < args[1];
-                               },
-                               "<",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] <= args[1];
-                               },
-                               "<=",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] || args[1];
-                               },
-                               "|",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
-                           {
-                               [](peach::expression::PeachTuple args) {
-                                   return args[0] && args[1];
-                               },
-                               "&",
-                               token::tokenCategory::OPERATOR_BI,
-                           },
+                           interpreter::makeOperatorInfo<expression::operators::Not>("!", token::tokenCategory::OPERATOR_UN),
+                           interpreter::makeOperatorInfo<expression::operators::Pow>("**", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Mul>("*", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Div>("/", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Mod>("%", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Add>("+", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Sub>("-", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Equal>("==", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::NotEqual>("!=", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Greater>(">", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::GreaterEqual>(">=", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Less>("<", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::LessEqual>("<=", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::Or>("|", token::tokenCategory::OPERATOR_BI),
+                           interpreter::makeOperatorInfo<expression::operators::And>("&", token::tokenCategory::OPERATOR_BI),
                        },
                        {
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left = right;
-                               },
-                               "=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left += right;
-                               },
-                               "+=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left -= right;
-                               },
-                               "-=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left *= right;
-                               },
-                               "*=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left /= right;
-                               },
-                               "/=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left %= right;
-                               },
-                               "%=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left &= right;
-                               },
-                               "&=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
-                           {
-                               [](peach::expression::VType &left, peach::expression::VType right) {
-                                   left |= right;
-                               },
-                               "|=",
-                               token::tokenCategory::ASSIGNMENT,
-                           },
+                           interpreter::makeAssignOperatorInfo<expression::operators::Assign>("=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::AddAssign>("+=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::SubAssign>("-=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::MulAssign>("*=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::DivAssign>("/=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::ModAssign>("%=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::AndAssign>("&=", token::tokenCategory::ASSIGNMENT),
+                           interpreter::makeAssignOperatorInfo<expression::operators::OrAssign>("|=", token::tokenCategory::ASSIGNMENT),
                        }),
-          keywords_({
-              {"if", token::tokenCategory::COND_IF},
-              {"else", token::tokenCategory::COND_ELSE},
-              {"while", token::tokenCategory::LOOP_WHILE},
-              {"let", token::tokenCategory::DECLARATION},
-          })
+          tokenizator_(LEXER_TABLES.getAutomaton()),
+          scope_(interpreter_.getSymbolTable())
+    {
+        // Lexer, interpreter and scope share symbol ids of names, interpreter finds operators by ids of lexer
+        interpreter_.setOperatorPatterns(OPERATORS);
+        tokenizator_.setKeywords(KEYWORDS)
+            .setSymbolTable(interpreter_.getSymbolTable())
+            .setIndentation(interpreter_.getSingleIndentationBlock());
+    }
+
+    // Sets engine of next evaluations, tree walking engine is used by default
+    void setEngine(Engine engine) noexcept
+    {
+        engine_ = engine;
+    }
+
+    Engine getEngine() const noexcept
+    {
+        return engine_;
+    }
+
+    // Evaluates expression in scope of cli with its engine
+    // JIT keeps hot loops of cli evaluations compiled, bytecode of expression is reused, if it is evaluated again
+    expression::VType evaluate(const expression::ExprShPtr &expression)
+    {
+        if (engine_ != Engine::TREE)
+        {
+            if (auto arenaExpression = std::dynamic_pointer_cast<expression::ArenaExpression>(expression))
+            {
+                if (expression != bytecodeSource_)
+                {
+                    bytecode_ = std::make_unique<expression::BytecodeExpression>(*arenaExpression);
+                    bytecodeSource_ = expression;
+                }
+                if (engine_ == Engine::JIT)
+                {
+                    return bytecode_->getProgram().run(scope_, &jit_);
+                }
+                return bytecode_->eval(scope_);
+            }
+        }
+        return expression->eval(scope_);
+    }
 
+    // Executes program from input source
+    void executeProgram(const InputSource &source, std::ostream &os)
     {
-        using peach::token::tokenCategory;
-        using peach::token::tokenCategory_t;
-        using namespace peach::transition;
-        tokenizator_
-            .buildAppendFsm<peach::fsm::NameFinder>()                                     //
-            .buildAppendFsm<peach::fsm::NumberFinder>(tokenCategory::VALUE_FLOATING, '.') //
-            .buildAppendFsm<peach::fsm::NumberFinder>(tokenCategory::VALUE_INT)           //
-            .buildAppendFsm<peach::fsm::OperatorFinder>(
-                std::vector<std::pair<std::string, tokenCategory_t>>{
-                    {"&=", tokenCategory::ASSIGNMENT},
-                    {"&", tokenCategory::OPERATOR_BI},
-                    {"|=", tokenCategory::ASSIGNMENT},
-                    {"|", tokenCategory::OPERATOR_BI},
-                    {"*=", tokenCategory::ASSIGNMENT},
-                    {"**", tokenCategory::OPERATOR_BI},
-                    {"*", tokenCategory::OPERATOR_BI},
-                    {"/=", tokenCategory::ASSIGNMENT},
-                    {"/", tokenCategory::OPERATOR_BI},
-                    {"%=", tokenCategory::ASSIGNMENT},
-                    {"%", tokenCategory::OPERATOR_BI},
-                    {"+=", tokenCategory::ASSIGNMENT},
-                    {"+", tokenCategory::OPERATOR_BI},
-                    {"-=", tokenCategory::ASSIGNMENT},
-                    {"-", tokenCategory::OPERATOR_BI},
-                    {"==", tokenCategory::OPERATOR_BI},
-                    {"=", tokenCategory::ASSIGNMENT},
-                    {"!=", tokenCategory::OPERATOR_BI},
-                    {"!", tokenCategory::OPERATOR_UN},
-                    {">", tokenCategory::OPERATOR_BI},
-                    {"<", tokenCategory::OPERATOR_BI},
-                    {">=", tokenCategory::OPERATOR_BI},
-                    {"<=", tokenCategory::OPERATOR_BI},
-                }) //
-            .buildAppendFsm<peach::fsm::SingleCharFinder>(
-                std::vector<std::pair<char, tokenCategory_t>>{
-                    {'\n', tokenCategory::SEP_ENDL},
-                    {' ', tokenCategory::SEP_SPACE},
-                    {'\t', tokenCategory::SEP_TAB},
-                    {'(', tokenCategory::BRACKET_OPEN},
-                    {')', tokenCategory::BRACKET_CLOSE},
-                }) //
-            ;
+        executeProgram(source.getText(), os);
     }
 
     // Executes program from istream
-    void executeProgram(std::ifstream &ifs, std::ostream &os)
+    void executeProgram(std::istream &is, std::ostream &os)
+    {
+        executeProgram(InputSource::fromStream(is), os);
+    }
+
+    // Executes program text, it is lexed in place
+    // Large programs are lexed and interpretated in parallel, others are lexed line by line while they are interpretated
+    void executeProgram(std::string_view programText, std::ostream &os)
+    {
+        if (programText.size() >= PARALLEL_LEXING_SIZE && std::thread::hardware_concurrency() > 1)
+        {
+            tools::ThreadPool pool;
+            auto tokens = tokenizator_.tokenizeText(programText, pool);
+            executeTokens(tokens, &pool, os);
+            return;
+        }
+        fsm::TokenStream stream(getLexer(), programText, interpreter_.getSymbolTable().get());
+        try
+        {
+            interpreter_.interpretateLines(stream);
+            os << evaluate(interpreter_.getInterpretationResult()) << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            os << e.what() << '\n';
+        }
+    }
+
+    // Executes tokenized program, its expressions are built by pool workers, if pool is given
+    void executeTokens(const token::TokenBuffer &tokens, tools::ThreadPool *pool, std::ostream &os)
+    {
+        try
+        {
+            if (pool)
+            {
+                interpreter_.interpretateLines(tokens.begin(), tokens.end(), *pool);
+            }
+            else
+            {
+                interpreter_.interpretateLines(tokens.begin(), tokens.end());
+            }
+            os << evaluate(interpreter_.getInterpretationResult()) << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            os << e.what() << '\n';
+        }
+    }
+
+    // Interpretates program text without executing it, returns its expression
+    // Throws exception of the first error of program
+    expression::ExprShPtr interpretateProgram(std::string_view programText)
+    {
+        fsm::TokenStream stream(getLexer(), programText, interpreter_.getSymbolTable().get());
+        interpreter_.interpretateLines(stream);
+        return interpreter_.getInterpretationResult();
+    }
+
+    // Checks program text without executing it, errors of all broken lines are written to os
+    // Program is lexed and interpretated once, returns number of errors
+    std::size_t checkProgram(std::string_view programText, std::ostream &os)
+    {
+        std::vector<exception::Diagnostic> diagnostics;
+        fsm::TokenStream stream(getLexer(), programText, interpreter_.getSymbolTable().get());
+        try
+        {
+            interpreter_.interpretateLines(stream, diagnostics);
+        }
+        catch (const std::exception &e)
+        {
+            os << e.what() << '\n';
+            interpreter_.reset();
+            return diagnostics.size() + 1;
+        }
+        for (const auto &diagnostic : diagnostics)
+        {
+            os << exception::formatDiagnostic(diagnostic) << '\n';
+        }
+        interpreter_.reset();
+        return diagnostics.size();
+    }
+
+    // Executes program, which is kept interpreted while it is edited
+    void executeProgram(const interpreter::IncrementalProgram &program, std::ostream &os)
     {
-        std::string programText((std::istreambuf_iterator<char>(ifs)),
-                                std::istreambuf_iterator<char>());
-        auto tokens = tokenizator_.tokenizeText(programText, keywords_);
         try
         {
-            interpreter_.interpretateLines(tokens.begin(), tokens.end());
-            os << interpreter_.getInterpretationResult()->eval(scope_) << std::endl;
+            os << evaluate(program.getProgram()) << std::endl;
         }
         catch (const std::exception &e)
         {
@@ -277,6 +271,57 @@ public:
         }
     }
 
+    // Executes statements of program from istream as soon as they are finished, results are written to os
+    // Program may be unbounded: reading, compilation and evaluation run on separate threads
+    // and pass lines and statements through bounded queues, so memory does not grow with program.
+    // Result or error of every top level statement is written, output is flushed, when no statement is ready.
+    void executeStream(std::istream &is, std::ostream &os, std::size_t queueCapacity = STREAM_QUEUE_CAPACITY)
+    {
+        tools::BoundedQueue<std::string> lines(queueCapacity);
+        tools::BoundedQueue<interpreter::StatementCompiler::Statement> statements(queueCapacity);
+        std::thread reader([&is, &lines]() {
+            std::string line;
+            while (std::getline(is, line))
+            {
+                lines.push(std::move(line));
+            }
+            lines.close();
+        });
+        std::thread compiler([this, &lines, &statements]() {
+            interpreter::StatementCompiler statementCompiler(getLexer(), interpreter_);
+            std::vector<interpreter::StatementCompiler::Statement> finished;
+            while (auto line = lines.pop())
+            {
+                statementCompiler.pushLine(*line, finished);
+                pushStatements(finished, statements);
+            }
+            statementCompiler.finish(finished);
+            pushStatements(finished, statements);
+            statements.close();
+        });
+        while (auto statement = statements.pop())
+        {
+            try
+            {
+                if (statement->error)
+                {
+                    std::rethrow_exception(statement->error);
+                }
+                os << evaluate(statement->expression) << '\n';
+            }
+            catch (const std::exception &e)
+            {
+                os << e.what() << '\n';
+            }
+            if (statements.empty())
+            {
+                os.flush();
+            }
+        }
+        reader.join();
+        compiler.join();
+    }
+
     // Main interface loop, activates cli
     void loop(std::istream &is, std::ostream &os)
     {
@@ -295,16 +340,15 @@ public:
             {
                 interpreter_.reset();
             }
-            tokenizator_.reset();
             std::string input;
             std::getline(is, input);
-            auto tokens = tokenizator_.tokenizeText(input, keywords_);
+            auto tokens = tokenizator_.tokenizeText(input);
             try
             {
                 interpreter_.interpretateLine(tokens.begin(), tokens.end());
                 if (interpreter_.getIndentationLevel() == 0 || tokens.empty())
                 {
-                    os << interpreter_.getInterpretationResult()->eval(scope_) << std::endl;
+                    os << evaluate(interpreter_.getInterpretationResult()) << std::endl;
                 }
             }
             catch (const std::exception &e)
@@ -314,6 +358,34 @@ public:
         }
     }
 
+    // Tokenizes text with cli lexer and keywords
+    // Tokens refer to text, so it must outlive them
+    token::TokenBuffer tokenize(std::string_view text)
+    {
+        return tokenizator_.tokenizeText(text);
+    }
+
+    // Tokenizes text like tokenize, but in parallel by chunks of lines
+    token::TokenBuffer tokenizeParallel(std::string_view text)
+    {
+        tools::ThreadPool pool;
+        return tokenizator_.tokenizeText(text, pool);
+    }
+
+    // Returns immutable lexer of cli, threads can share it to tokenize concurrently
+    // Each thread must intern names into its own symbol table
+    std::shared_ptr<const fsm::Lexer> getLexer()
+    {
+        return tokenizator_.getLexer();
+    }
+
+    // Returns empty program, which is lexed and interpretated like cli programs
+    // Edits of program re-interpretate only changed top level blocks
+    interpreter::IncrementalProgram makeIncrementalProgram()
+    {
+        return interpreter::IncrementalProgram(getLexer(), interpreter_);
+    }
+
     // Retuns reference on current state of cli
     expression::Scope &getScope()
     {
@@ -321,10 +393,24 @@ public:
     }
 
 private:
-    fsm::FsmCollection tokenizator_;
+    // Moves finished statements to queue
+    static void pushStatements(std::vector<interpreter::StatementCompiler::Statement> &finished,
+                               tools::BoundedQueue<interpreter::StatementCompiler::Statement> &statements)
+    {
+        for (auto &statement : finished)
+        {
+            statements.push(std::move(statement));
+        }
+        finished.clear();
+    }
+
     interpreter::Interpreter interpreter_;
-    const std::vector<std::pair<std::string, peach::token::tokenCategory_t>> keywords_;
+    fsm::FsmCollection tokenizator_;
     expression::Scope scope_;
+    Engine engine_ = Engine::TREE;
+    expression::ExprShPtr bytecodeSource_;                   // expression evaluated last by bytecode engine
+    std::unique_ptr<expression::BytecodeExpression> bytecode_; // its bytecode, so it keeps compiled loops, if it is evaluated again
+    expression::LoopJit jit_;                                // compiles hot loops of all evaluations of cli
 };
 } // namespace cli
 } // namespace peach
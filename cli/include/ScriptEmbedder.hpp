@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PeachCli.hpp"
+
+namespace peach
+{
+namespace cli
+{
+// Translates peach script to C++ function peach::embedded::<name>(Scope &), which runs it in scope
+// Script is interpretated with operators of PeachCli, its expression becomes straight-line code,
+// which calls the same builtin operators, so results and errors are the same as ones of PeachCli.
+// Variables of script are bound to variables of scope with the same names.
+class ScriptEmbedder
+{
+public:
+    // Throws exception of the first error of script, std::invalid_argument, if function name is not identifier
+    ScriptEmbedder(std::string_view scriptText, std::string functionName, std::string scriptName = "script")
+        : functionName_(std::move(functionName))
+        , scriptName_(std::move(scriptName))
+    {
+        if (!isIdentifier(functionName_))
+        {
+            throw std::invalid_argument("embedded function name is not identifier: " + functionName_);
+        }
+        PeachCli cli;
+        auto expression = std::dynamic_pointer_cast<expression::ArenaExpression>(cli.interpretateProgram(scriptText));
+        if (!expression)
+        {
+            throw std::logic_error("interpretated script is not arena expression");
+        }
+        arena_ = expression->getArena();
+        symbols_ = cli.getScope().getSymbolTable();
+        result_ = compile(expression->getRoot(), 1);
+    }
+
+    // Returns header, which declares function
+    std::string generateHeader() const
+    {
+        std::ostringstream os;
+        os << "#pragma once\n\n"
+           << "// Generated by peach-embed from " << scriptName_ << ", do not edit\n\n"
+           << "#include \"Expression.hpp\"\n\n"
+           << "namespace peach\n{\nnamespace embedded\n{\n"
+           << "// Runs " << scriptName_ << " in scope, returns value of its last statement\n"
+           << "expression::VType " << functionName_ << "(expression::Scope &scope);\n"
+           << "} // namespace embedded\n} // namespace peach\n";
+        return os.str();
+    }
+
+    // Returns source, which defines function, header is included as <function name>.hpp
+    std::string generateSource() const
+    {
+        std::ostringstream os;
+        os << "// Generated by peach-embed from " << scriptName_ << ", do not edit\n\n"
+           << "#include \"" << functionName_ << ".hpp\"\n\n"
+           << "#include \"Embedded.hpp\"\n\n"
+           << "namespace peach\n{\nnamespace embedded\n{\n"
+           << "expression::VType " << functionName_ << "(expression::Scope &scope)\n{\n"
+           << "    using namespace expression;\n"
+           << "    using namespace expression::operators;\n";
+        for (std::size_t i = 0; i < variables_.size(); ++i)
+        {
+            os << "    EmbeddedVariable " << getVariableName(i) << "(scope, \"" << symbols_->getName(variables_[i]) << "\");\n";
+        }
+        if (variables_.empty())
+        {
+            os << "    (void)scope;\n";
+        }
+        os << "    auto store = [&] {\n";
+        for (std::size_t i = 0; i < variables_.size(); ++i)
+        {
+            os << "        " << getVariableName(i) << ".store(scope);\n";
+        }
+        os << "    };\n"
+           << "    VType result{};\n"
+           << "    try\n    {\n"
+           << body_.str()
+           << "        result = " << result_ << ";\n"
+           << "    }\n"
+           << "    catch (...)\n    {\n"
+           << "        store();\n"
+           << "        throw;\n"
+           << "    }\n"
+           << "    store();\n"
+           << "    return result;\n"
+           << "}\n"
+           << "} // namespace embedded\n} // namespace peach\n";
+        return os.str();
+    }
+
+private:
+    using NodeKind = expression::ExpressionArena::NodeKind;
+
+    static bool isIdentifier(std::string_view name) noexcept
+    {
+        if (name.empty() || (name[0] >= '0' && name[0] <= '9'))
+        {
+            return false;
+        }
+        for (char c : name)
+        {
+            if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Returns name of C++ functor of builtin operator node kind
+    static const char *getOperatorName(NodeKind kind)
+    {
+        switch (kind)
+        {
+        case NodeKind::NOT: return "Not";
+        case NodeKind::POW: return "Pow";
+        case NodeKind::MUL: return "Mul";
+        case NodeKind::DIV: return "Div";
+        case NodeKind::MOD: return "Mod";
+        case NodeKind::ADD: return "Add";
+        case NodeKind::SUB: return "Sub";
+        case NodeKind::EQUAL: return "Equal";
+        case NodeKind::NOT_EQUAL: return "NotEqual";
+        case NodeKind::GREATER: return "Greater";
+        case NodeKind::GREATER_EQUAL: return "GreaterEqual";
+        case NodeKind::LESS: return "Less";
+        case NodeKind::LESS_EQUAL: return "LessEqual";
+        case NodeKind::OR: return "Or";
+        case NodeKind::AND: return "And";
+        case NodeKind::ASSIGN_BUILTIN: return "Assign";
+        case NodeKind::ADD_ASSIGN: return "AddAssign";
+        case NodeKind::SUB_ASSIGN: return "SubAssign";
+        case NodeKind::MUL_ASSIGN: return "MulAssign";
+        case NodeKind::DIV_ASSIGN: return "DivAssign";
+        case NodeKind::MOD_ASSIGN: return "ModAssign";
+        case NodeKind::AND_ASSIGN: return "AndAssign";
+        case NodeKind::OR_ASSIGN: return "OrAssign";
+        default:
+            throw std::invalid_argument("script uses operator, which is not builtin");
+        }
+    }
+
+    static std::string getVariableName(std::size_t index)
+    {
+        return "v" + std::to_string(index);
+    }
+
+    // Returns C++ variable of script variable symbol
+    std::string getVariable(token::symbol_t symbol)
+    {
+        for (std::size_t i = 0; i < variables_.size(); ++i)
+        {
+            if (variables_[i] == symbol)
+            {
+                return getVariableName(i);
+            }
+        }
+        variables_.push_back(symbol);
+        return getVariableName(variables_.size() - 1);
+    }
+
+    std::string makeTemporary()
+    {
+        return "t" + std::to_string(temporaries_++);
+    }
+
+    std::ostream &line(std::size_t indent)
+    {
+        return body_ << std::string(4 * (indent + 1), ' ');
+    }
+
+    // Emits temporary constant with value of C++ expression, returns its name
+    // Values of statements may be unused, so temporaries are marked
+    std::string emitConstant(std::size_t indent, const std::string &value)
+    {
+        std::string temporary = makeTemporary();
+        line(indent) << "[[maybe_unused]] const VType " << temporary << " = " << value << ";\n";
+        return temporary;
+    }
+
+    // Emits statements of node in order of tree walking evaluation
+    // Returns C++ expression of node value, which is constant or temporary
+    std::string compile(expression::node_t node, std::size_t indent)
+    {
+        const auto &current = arena_->getNode(node);
+        switch (current.kind)
+        {
+        case NodeKind::VALUE:
+        {
+            auto value = static_cast<expression::VType>(current.first);
+            if (value == std::numeric_limits<expression::VType>::min())
+            {
+                return "VType(" + std::to_string(value + 1) + " - 1)";
+            }
+            return "VType(" + std::to_string(value) + ")";
+        }
+
+        case NodeKind::VARIABLE_ACCESS:
+            return emitConstant(indent, getVariable(current.first) + ".load()");
+
+        case NodeKind::VARIABLE_DECLARATION:
+            return emitConstant(indent, getVariable(current.first) + ".declare()");
+
+        case NodeKind::CONDITIONAL:
+        {
+            std::string temporary = makeTemporary();
+            line(indent) << "[[maybe_unused]] VType " << temporary << "{};\n";
+            std::string condition = compile(current.first, indent);
+            line(indent) << "if (" << condition << ")\n";
+            line(indent) << "{\n";
+            std::string ifWay = compile(current.second, indent + 1);
+            line(indent + 1) << temporary << " = " << ifWay << ";\n";
+            line(indent) << "}\n";
+            if (current.third != expression::ExpressionArena::NO_NODE)
+            {
+                line(indent) << "else\n";
+                line(indent) << "{\n";
+                std::string elseWay = compile(current.third, indent + 1);
+                line(indent + 1) << temporary << " = " << elseWay << ";\n";
+                line(indent) << "}\n";
+            }
+            return temporary;
+        }
+
+        case NodeKind::LOOP_WHILE:
+        {
+            std::string temporary = makeTemporary();
+            line(indent) << "[[maybe_unused]] VType " << temporary << "{};\n";
+            line(indent) << "for (;;)\n";
+            line(indent) << "{\n";
+            std::string condition = compile(current.first, indent + 1);
+            line(indent + 1) << "if (!" << condition << ")\n";
+            line(indent + 1) << "{\n";
+            line(indent + 2) << "break;\n";
+            line(indent + 1) << "}\n";
+            std::string body = compile(current.second, indent + 1);
+            line(indent + 1) << temporary << " = " << body << ";\n";
+            line(indent) << "}\n";
+            return temporary;
+        }
+
+        case NodeKind::SEQUENCE:
+        {
+            std::string result = "VType(0)";
+            for (std::uint32_t child = current.first; child < current.first + current.second; ++child)
+            {
+                result = compile(arena_->getChild(child), indent);
+            }
+            return result;
+        }
+
+        case NodeKind::NOT:
+            return emitConstant(indent, "Not()(" + compile(current.first, indent) + ")");
+
+        default:
+            if (expression::ExpressionArena::isAssignment(current.kind))
+            {
+                std::string assignment = getOperatorName(current.kind);
+                std::string right = compile(current.second, indent);
+                return emitConstant(indent, getVariable(current.first) + ".assign(" + assignment + "(), " + right + ")");
+            }
+            std::string op = getOperatorName(current.kind);
+            std::string left = compile(current.first, indent);
+            std::string right = compile(current.second, indent);
+            return emitConstant(indent, op + "()(" + left + ", " + right + ")");
+        }
+    }
+
+    std::string functionName_;
+    std::string scriptName_;
+    std::shared_ptr<const expression::ExpressionArena> arena_;
+    std::shared_ptr<token::SymbolTable> symbols_;
+    std::vector<token::symbol_t> variables_; // symbols of script variables in order of their C++ variables
+    std::size_t temporaries_ = 0;            // number of emitted temporaries
+    std::ostringstream body_;                // statements of function body
+    std::string result_;                     // expression of script value
+};
+} // namespace cli
+} // namespace peach
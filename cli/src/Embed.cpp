@@ -0,0 +1,45 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "InputSource.hpp"
+#include "ScriptEmbedder.hpp"
+
+namespace
+{
+// Writes text to file, returns if it is written
+bool writeFile(const std::string &path, const std::string &text)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+    return static_cast<bool>(file);
+}
+} // namespace
+
+// Generates <function-name>.hpp and <function-name>.cpp of script in output directory
+// Usage: peach-embed <script> <function-name> <output-directory>
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "usage: " << argv[0] << " <script> <function-name> <output-directory>\n";
+        return 1;
+    }
+    std::string script = argv[1], functionName = argv[2], directory = argv[3];
+    try
+    {
+        auto source = peach::cli::InputSource::fromFile(script);
+        peach::cli::ScriptEmbedder embedder(source.getText(), functionName, script.substr(script.find_last_of('/') + 1));
+        std::string path = directory + "/" + functionName;
+        if (!writeFile(path + ".hpp", embedder.generateHeader()) || !writeFile(path + ".cpp", embedder.generateSource()))
+        {
+            std::cerr << "can not write " << path << ".hpp and " << path << ".cpp\n";
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << script << ": " << e.what() << '\n';
+        return 1;
+    }
+}
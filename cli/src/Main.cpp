@@ -1,16 +1,57 @@
-#include <fstream>
+#include <iostream>
+#include <string_view>
 
 #include "PeachCli.hpp"
 
 int main(int argc, char **argv)
 {
-    if (argc > 1)
+    peach::cli::PeachCli cli;
+    int arg = 1;
+    if (argc > arg && std::string_view(argv[arg]) == "--bytecode")
     {
-        auto infile = std::ifstream(argv[1]);
-        peach::cli::PeachCli().executeProgram(infile, std::cout);
+        cli.setEngine(peach::cli::PeachCli::Engine::BYTECODE);
+        ++arg;
+    }
+    else if (argc > arg && std::string_view(argv[arg]) == "--jit")
+    {
+        cli.setEngine(peach::cli::PeachCli::Engine::JIT);
+        ++arg;
+    }
+
+    if (argc > arg && std::string_view(argv[arg]) == "--stream")
+    {
+        cli.executeStream(std::cin, std::cout);
+    }
+    else if (argc > arg + 1 && std::string_view(argv[arg]) == "--check")
+    {
+        peach::cli::InputSource source;
+        try
+        {
+            source = peach::cli::InputSource::fromFile(argv[arg + 1]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+        return cli.checkProgram(source.getText(), std::cout) == 0 ? 0 : 1;
+    }
+    else if (argc > arg)
+    {
+        peach::cli::InputSource source;
+        try
+        {
+            source = peach::cli::InputSource::fromFile(argv[arg]);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+        cli.executeProgram(source, std::cout);
     }
     else
     {
-        peach::cli::PeachCli().loop(std::cin, std::cout);
+        cli.loop(std::cin, std::cout);
     }
 }
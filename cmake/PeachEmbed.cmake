@@ -0,0 +1,23 @@
+# peach_embed_script(<target> <script>)
+# Compiles peach script to C++ function peach::embedded::<name>(peach::expression::Scope &) at build time
+# and links it into target. Name is script file name without extension, made C identifier.
+# Target includes generated header <name>.hpp, script is regenerated, when it or peach-embed changes.
+function(peach_embed_script TARGET SCRIPT)
+    get_filename_component(SCRIPT_PATH ${SCRIPT} ABSOLUTE)
+    get_filename_component(SCRIPT_NAME ${SCRIPT} NAME_WE)
+    string(MAKE_C_IDENTIFIER ${SCRIPT_NAME} FUNCTION_NAME)
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/peach_embedded)
+
+    add_custom_command(
+        OUTPUT ${OUTPUT_DIR}/${FUNCTION_NAME}.hpp ${OUTPUT_DIR}/${FUNCTION_NAME}.cpp
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+        COMMAND peach-embed ${SCRIPT_PATH} ${FUNCTION_NAME} ${OUTPUT_DIR}
+        DEPENDS peach-embed ${SCRIPT_PATH}
+        COMMENT "Embedding peach script ${SCRIPT}"
+        VERBATIM
+    )
+
+    target_sources(${TARGET} PRIVATE ${OUTPUT_DIR}/${FUNCTION_NAME}.cpp ${OUTPUT_DIR}/${FUNCTION_NAME}.hpp)
+    target_include_directories(${TARGET} PRIVATE ${OUTPUT_DIR})
+    target_link_libraries(${TARGET} peach_core)
+endfunction()
@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Exception.hpp"
+#include "Expression.hpp"
+#include "ExpressionArena.hpp"
+#include "Operators.hpp"
+
+// Bytecode is dispatched by computed goto, if compiler supports labels as values
+#if defined(__GNUC__) && !defined(PEACH_SWITCH_DISPATCH)
+#define PEACH_THREADED_DISPATCH
+#endif
+
+namespace peach
+{
+namespace expression
+{
+// Operation of bytecode stack machine
+// Every operation takes its operands from the top of value stack and pushes its result
+enum class Opcode : std::uint8_t
+{
+    PUSH,          // pushes arg
+    LOAD,          // pushes variable arg
+    DECLARE,       // declares variable arg, pushes its value
+    POP,           // pops value
+    JUMP,          // jumps to instruction arg
+    JUMP_IF_FALSE, // pops value, jumps to instruction arg, if it is zero
+    LOOP,          // jumps back to header arg of loop function
+    CALL_UNARY,    // replaces value with result of call function
+    CALL_BINARY,   // replaces two values with result of call function
+    ASSIGN,        // pops value, assigns it to variable arg with assignment function, pushes variable
+    HALT,          // finishes program, its result is on the top
+
+    // Builtin operators in order of BuiltinOperator, assignment operators assign variable arg
+    NOT,
+    POW,
+    MUL,
+    DIV,
+    MOD,
+    ADD,
+    SUB,
+    EQUAL,
+    NOT_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    OR,
+    AND,
+    ASSIGN_BUILTIN,
+    ADD_ASSIGN,
+    SUB_ASSIGN,
+    MUL_ASSIGN,
+    DIV_ASSIGN,
+    MOD_ASSIGN,
+    AND_ASSIGN,
+    OR_ASSIGN,
+};
+
+// Returns opcode of builtin operator
+constexpr Opcode getBuiltinOpcode(BuiltinOperator op) noexcept
+{
+    return static_cast<Opcode>(static_cast<std::uint8_t>(Opcode::NOT) + static_cast<std::uint8_t>(op));
+}
+
+static_assert(getBuiltinOpcode(BuiltinOperator::OR_ASSIGN) == Opcode::OR_ASSIGN, "builtin opcodes must follow BuiltinOperator");
+
+// Instruction is 12 bytes, function is index of operator function of call or assignment
+struct Instruction
+{
+    Opcode op;
+    std::uint32_t arg = 0;
+    std::uint32_t function = 0;
+};
+
+// While loop of bytecode program: header is address of its condition, end is the first address after loop
+struct LoopInfo
+{
+    std::uint32_t header;
+    std::uint32_t end;
+};
+
+class BytecodeProgram;
+
+// Runs loops of bytecode program in other way than virtual machine, for example as native code
+// Virtual machine calls it on every back edge of loop before jumping to loop header.
+class LoopAccelerator
+{
+public:
+    // Address, which means that loop is not accelerated
+    static constexpr std::uint32_t NO_ADDRESS = static_cast<std::uint32_t>(-1);
+
+    virtual ~LoopAccelerator() = default;
+
+    // Runs loop from its header with stack and scope of virtual machine, stack has size of header stack depth
+    // Returns address, where virtual machine continues with its stack depth, or NO_ADDRESS to run loop itself
+    virtual std::uint32_t runLoop(const BytecodeProgram &program, std::uint32_t loop, VType *stack, Scope &scope) = 0;
+};
+
+// Expression of arena, lowered to bytecode of stack machine
+// Conditionals and loops become conditional jumps, so program runs in single loop without recursion.
+// Results and errors are the same as ones of tree walking evaluation of arena.
+class BytecodeProgram
+{
+public:
+    BytecodeProgram(std::shared_ptr<const ExpressionArena> arena, node_t root)
+        : arena_(std::move(arena))
+    {
+        if (!arena_)
+        {
+            throw std::invalid_argument("nullptr arena in BytecodeProgram constructor");
+        }
+        functions_ = arena_->getFunctions().get();
+        compile(root);
+        emit({Opcode::HALT}, 0);
+    }
+
+    // Runs program, returns value of its expression
+    // Back edges of loops are passed to accelerator, if it is set
+    VType run(Scope &scope, LoopAccelerator *accelerator = nullptr) const
+    {
+        std::vector<VType> stack(maxStackSize_);
+        VType *top = stack.data(); // the next free place of stack
+        const Instruction *code = code_.data();
+        const Instruction *ip = code;
+
+#ifdef PEACH_THREADED_DISPATCH
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+        // Labels in order of Opcode
+        static void *const LABELS[] = {
+            &&PUSH, &&LOAD, &&DECLARE, &&POP, &&JUMP, &&JUMP_IF_FALSE, &&LOOP, &&CALL_UNARY, &&CALL_BINARY, &&ASSIGN,
+            &&HALT, &&NOT, &&POW, &&MUL, &&DIV, &&MOD, &&ADD, &&SUB, &&EQUAL, &&NOT_EQUAL, &&GREATER, &&GREATER_EQUAL, &&LESS,
+            &&LESS_EQUAL, &&OR, &&AND, &&ASSIGN_BUILTIN, &&ADD_ASSIGN, &&SUB_ASSIGN, &&MUL_ASSIGN, &&DIV_ASSIGN,
+            &&MOD_ASSIGN, &&AND_ASSIGN, &&OR_ASSIGN};
+#define PEACH_VM_CASE(name) name:
+#define PEACH_VM_DISPATCH() goto *LABELS[static_cast<std::size_t>(ip->op)]
+        PEACH_VM_DISPATCH();
+#else
+#define PEACH_VM_CASE(name) case Opcode::name:
+#define PEACH_VM_DISPATCH() continue
+        for (;;)
+        {
+            switch (ip->op)
+            {
+#endif
+        PEACH_VM_CASE(PUSH)
+            *top++ = static_cast<VType>(ip++->arg);
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(LOAD)
+        {
+            const VType *value = scope.find(ip++->arg);
+            if (!value)
+            {
+                exception::throwFromCoords<exception::UnknownVariableError>(111, 222); // Expression must know its position
+            }
+            *top++ = *value;
+            PEACH_VM_DISPATCH();
+        }
+
+        PEACH_VM_CASE(DECLARE)
+            if (scope.hasName(ip->arg))
+            {
+                exception::throwFromCoords<exception::VariableRedeclaration>(0, 0); // Expression must know its position
+            }
+            *top++ = scope.declare(ip++->arg);
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(POP)
+            --top;
+            ++ip;
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(JUMP)
+            ip = code + ip->arg;
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(JUMP_IF_FALSE)
+            ip = *--top ? ip + 1 : code + ip->arg;
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(LOOP)
+            if (accelerator)
+            {
+                std::uint32_t next = accelerator->runLoop(*this, ip->function, stack.data(), scope);
+                if (next != LoopAccelerator::NO_ADDRESS)
+                {
+                    ip = code + next;
+                    top = stack.data() + depths_[next];
+                    PEACH_VM_DISPATCH();
+                }
+            }
+            ip = code + ip->arg;
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(CALL_UNARY)
+            top[-1] = functions_->calls[ip++->function](PeachTuple{top[-1]});
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(CALL_BINARY)
+            --top;
+            top[-1] = functions_->calls[ip++->function](PeachTuple{top[-1], top[0]});
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(ASSIGN)
+            assign(top, *ip, scope, functions_->assignments[ip->function]);
+            ++ip;
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(HALT)
+            return top[-1];
+
+        PEACH_VM_CASE(NOT)
+            top[-1] = operators::Not()(top[-1]);
+            ++ip;
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(POW)
+            applyBinary<operators::Pow>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(MUL)
+            applyBinary<operators::Mul>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(DIV)
+            applyBinary<operators::Div>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(MOD)
+            applyBinary<operators::Mod>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(ADD)
+            applyBinary<operators::Add>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(SUB)
+            applyBinary<operators::Sub>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(EQUAL)
+            applyBinary<operators::Equal>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(NOT_EQUAL)
+            applyBinary<operators::NotEqual>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(GREATER)
+            applyBinary<operators::Greater>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(GREATER_EQUAL)
+            applyBinary<operators::GreaterEqual>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(LESS)
+            applyBinary<operators::Less>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(LESS_EQUAL)
+            applyBinary<operators::LessEqual>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(OR)
+            applyBinary<operators::Or>(top, ip);
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(AND)
+            applyBinary<operators::And>(top, ip);
+            PEACH_VM_DISPATCH();
+
+        PEACH_VM_CASE(ASSIGN_BUILTIN)
+            assign(top, *ip++, scope, operators::Assign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(ADD_ASSIGN)
+            assign(top, *ip++, scope, operators::AddAssign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(SUB_ASSIGN)
+            assign(top, *ip++, scope, operators::SubAssign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(MUL_ASSIGN)
+            assign(top, *ip++, scope, operators::MulAssign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(DIV_ASSIGN)
+            assign(top, *ip++, scope, operators::DivAssign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(MOD_ASSIGN)
+            assign(top, *ip++, scope, operators::ModAssign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(AND_ASSIGN)
+            assign(top, *ip++, scope, operators::AndAssign());
+            PEACH_VM_DISPATCH();
+        PEACH_VM_CASE(OR_ASSIGN)
+            assign(top, *ip++, scope, operators::OrAssign());
+            PEACH_VM_DISPATCH();
+
+#ifdef PEACH_THREADED_DISPATCH
+#pragma GCC diagnostic pop
+#else
+            }
+            throw std::logic_error("unknown bytecode operation");
+        }
+#endif
+#undef PEACH_VM_CASE
+#undef PEACH_VM_DISPATCH
+    }
+
+    const std::vector<Instruction> &getInstructions() const noexcept
+    {
+        return code_;
+    }
+
+    // Returns loops, LOOP instruction of loop has its index as function
+    const std::vector<LoopInfo> &getLoops() const noexcept
+    {
+        return loops_;
+    }
+
+    // Returns stack size before execution of instruction at address
+    std::uint32_t getStackDepth(std::uint32_t address) const
+    {
+        return depths_.at(address);
+    }
+
+    std::size_t getMaxStackSize() const noexcept
+    {
+        return maxStackSize_;
+    }
+
+    const OperatorFunctions &getFunctions() const noexcept
+    {
+        return *functions_;
+    }
+
+    // Returns id of program, ids are not reused in process, so accelerator keeps state of program by it
+    std::uint64_t getId() const noexcept
+    {
+        return id_;
+    }
+
+private:
+    static std::uint64_t makeId() noexcept
+    {
+        static std::atomic<std::uint64_t> lastId{0};
+        return ++lastId;
+    }
+
+    // Replaces two values with result of operator, moves to the next instruction
+    template <typename OperatorT>
+    static void applyBinary(VType *&top, const Instruction *&ip)
+    {
+        --top;
+        top[-1] = OperatorT()(top[-1], top[0]);
+        ++ip;
+    }
+
+    // Replaces value with assigned variable of instruction
+    template <typename AssignT>
+    static void assign(VType *top, const Instruction &instruction, Scope &scope, const AssignT &assignment)
+    {
+        VType *left = scope.find(instruction.arg);
+        if (!left)
+        {
+            exception::throwFromCoords<exception::UnknownVariableError>(0, 0);
+        }
+        assignment(*left, top[-1]);
+        top[-1] = *left;
+    }
+
+    // Emits code of node, which pushes its value
+    void compile(node_t node)
+    {
+        using NodeKind = ExpressionArena::NodeKind;
+        const auto &current = arena_->getNode(node);
+        switch (current.kind)
+        {
+        case NodeKind::VALUE:
+            emit({Opcode::PUSH, current.first}, 1);
+            return;
+
+        case NodeKind::VARIABLE_ACCESS:
+            emit({Opcode::LOAD, current.first}, 1);
+            return;
+
+        case NodeKind::VARIABLE_DECLARATION:
+            emit({Opcode::DECLARE, current.first}, 1);
+            return;
+
+        case NodeKind::CALL:
+            compile(current.first);
+            if (current.second == ExpressionArena::NO_NODE)
+            {
+                emit({Opcode::CALL_UNARY, 0, current.third}, 0);
+                return;
+            }
+            compile(current.second);
+            emit({Opcode::CALL_BINARY, 0, current.third}, -1);
+            return;
+
+        case NodeKind::ASSIGN:
+            compile(current.second);
+            emit({Opcode::ASSIGN, current.first, current.third}, 0);
+            return;
+
+        case NodeKind::CONDITIONAL:
+        {
+            compile(current.first);
+            std::size_t jumpToElse = emit({Opcode::JUMP_IF_FALSE}, -1);
+            compile(current.second);
+            std::size_t jumpToEnd = emit({Opcode::JUMP}, -1); // else way pushes its own value
+            code_[jumpToElse].arg = getAddress();
+            if (current.third != ExpressionArena::NO_NODE)
+            {
+                compile(current.third);
+            }
+            else
+            {
+                emit({Opcode::PUSH, 0}, 1);
+            }
+            code_[jumpToEnd].arg = getAddress();
+            return;
+        }
+
+        case NodeKind::LOOP_WHILE:
+        {
+            emit({Opcode::PUSH, 0}, 1); // result of loop without iterations
+            std::uint32_t begin = getAddress();
+            compile(current.first);
+            std::size_t jumpToEnd = emit({Opcode::JUMP_IF_FALSE}, -1);
+            emit({Opcode::POP}, -1); // result of previous iteration
+            compile(current.second);
+            emit({Opcode::LOOP, begin, static_cast<std::uint32_t>(loops_.size())}, 0);
+            code_[jumpToEnd].arg = getAddress();
+            loops_.push_back({begin, getAddress()});
+            return;
+        }
+
+        case NodeKind::SEQUENCE:
+            if (current.second == 0)
+            {
+                emit({Opcode::PUSH, 0}, 1);
+                return;
+            }
+            for (std::uint32_t child = current.first; child < current.first + current.second; ++child)
+            {
+                if (child != current.first)
+                {
+                    emit({Opcode::POP}, -1);
+                }
+                compile(arena_->getChild(child));
+            }
+            return;
+
+        case NodeKind::NOT:
+            compile(current.first);
+            emit({Opcode::NOT}, 0);
+            return;
+
+        default:
+            if (ExpressionArena::isAssignment(current.kind))
+            {
+                compile(current.second);
+                emit({getOpcode(current.kind), current.first}, 0);
+                return;
+            }
+            compile(current.first);
+            compile(current.second);
+            emit({getOpcode(current.kind)}, -1);
+            return;
+        }
+    }
+
+    // Returns opcode of builtin operator node kind
+    static Opcode getOpcode(ExpressionArena::NodeKind kind) noexcept
+    {
+        return static_cast<Opcode>(static_cast<std::uint8_t>(kind) - static_cast<std::uint8_t>(ExpressionArena::NodeKind::NOT) +
+                                   static_cast<std::uint8_t>(Opcode::NOT));
+    }
+
+    // Appends instruction, which changes stack size by stackEffect, returns its address
+    std::size_t emit(Instruction instruction, int stackEffect)
+    {
+        if (code_.size() >= ExpressionArena::NO_NODE)
+        {
+            throw std::length_error("too many instructions in bytecode program");
+        }
+        code_.push_back(instruction);
+        depths_.push_back(static_cast<std::uint32_t>(stackSize_));
+        stackSize_ += stackEffect;
+        maxStackSize_ = std::max(maxStackSize_, stackSize_);
+        return code_.size() - 1;
+    }
+
+    std::uint32_t getAddress() const noexcept
+    {
+        return static_cast<std::uint32_t>(code_.size());
+    }
+
+    std::shared_ptr<const ExpressionArena> arena_; // arena of compiled expression, it keeps operator functions alive
+    const OperatorFunctions *functions_ = nullptr; // functions of generic calls and assignments
+    std::vector<Instruction> code_;                // instructions of program
+    std::vector<std::uint32_t> depths_;            // stack size before each instruction
+    std::vector<LoopInfo> loops_;                  // while loops in order of their ends
+    std::size_t stackSize_ = 0;                    // stack size after the last emitted instruction
+    std::size_t maxStackSize_ = 1;                 // stack size, which program needs
+    std::uint64_t id_ = makeId();                  // id of program, copy has the same code, so it keeps id
+};
+
+// Expression of arena, which is evaluated by bytecode program instead of tree walking
+class BytecodeExpression : public Expression
+{
+public:
+    BytecodeExpression(std::shared_ptr<const ExpressionArena> arena, node_t root)
+        : program_(std::move(arena), root)
+    {
+    }
+
+    explicit BytecodeExpression(const ArenaExpression &expression)
+        : BytecodeExpression(expression.getArena(), expression.getRoot())
+    {
+    }
+
+    VType eval(Scope &scope) override
+    {
+        return program_.run(scope);
+    }
+
+    const BytecodeProgram &getProgram() const noexcept
+    {
+        return program_;
+    }
+
+private:
+    BytecodeProgram program_;
+};
+} // namespace expression
+} // namespace peach
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string_view>
+
+#include "Exception.hpp"
+#include "Expression.hpp"
+#include "Operators.hpp"
+
+namespace peach
+{
+namespace expression
+{
+// Variable of script, which is compiled to C++, bound by name to variable of host scope
+// Script works with local copy of value: it is read from scope on binding and written back by store.
+// Errors are the same as ones of tree walking evaluation of variable nodes.
+class EmbeddedVariable
+{
+public:
+    EmbeddedVariable(Scope &scope, std::string_view name)
+        : name_(name)
+    {
+        if (scope.hasName(name))
+        {
+            value_ = scope[name];
+            declared_ = true;
+        }
+    }
+
+    // Returns value of variable access, throws UnknownVariableError, if variable is not declared
+    VType load() const
+    {
+        if (!declared_)
+        {
+            exception::throwFromCoords<exception::UnknownVariableError>(111, 222); // Expression must know its position
+        }
+        return value_;
+    }
+
+    // Declares variable, returns its value
+    // Throws VariableRedeclaration, if variable is already declared
+    VType declare()
+    {
+        if (declared_)
+        {
+            exception::throwFromCoords<exception::VariableRedeclaration>(0, 0); // Expression must know its position
+        }
+        declared_ = true;
+        return value_ = VType{};
+    }
+
+    // Assigns right operand with assignment operator, returns value of variable
+    // Throws UnknownVariableError, if variable is not declared
+    template <typename AssignT>
+    VType assign(const AssignT &assignment, VType right)
+    {
+        if (!declared_)
+        {
+            exception::throwFromCoords<exception::UnknownVariableError>(0, 0);
+        }
+        assignment(value_, right);
+        return value_;
+    }
+
+    // Writes declared variable to scope
+    void store(Scope &scope) const
+    {
+        if (declared_)
+        {
+            scope.declare(name_, value_);
+        }
+    }
+
+private:
+    std::string_view name_; // name of variable, it is string literal of generated code
+    VType value_{};
+    bool declared_ = false;
+};
+} // namespace expression
+} // namespace peach
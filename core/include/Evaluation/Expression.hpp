@@ -1,15 +1,18 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 
 #include "Exception.hpp"
+#include "SymbolTable.hpp"
 #include "Token.hpp"
 
 namespace peach
@@ -20,36 +23,95 @@ namespace expression
 using VType = std::int32_t; // TODO: literals at least
 
 // Scope is the current state of visible variables
+// Variables are kept in flat frame of slots, which are indexed by symbol ids of their names,
+// so compiled expressions find variable by single index. Names of host API are resolved through symbol table of scope.
 class Scope
 {
 public:
-    // Returns VType that corresponds to varName
-    // If scope does not contain such varName, throws UnknownVariableError
-    VType &operator[](const std::string &varName)
+    explicit Scope(std::shared_ptr<token::SymbolTable> symbols = std::make_shared<token::SymbolTable>())
+        : symbols_(std::move(symbols))
+    {
+    }
+
+    // Returns VType that corresponds to symbol
+    // If scope does not contain such symbol, throws UnknownVariableError
+    VType &operator[](token::symbol_t symbol)
     {
-        auto it = memory_.find(varName);
-        if (it == memory_.end())
+        VType *value = find(symbol);
+        if (!value)
         {
             exception::throwFromCoords<exception::UnknownVariableError>(0, 0);
         }
-        return it->second;
+        return *value;
+    }
+
+    // Returns value of variable symbol, nullptr if it is not declared
+    VType *find(token::symbol_t symbol) noexcept
+    {
+        if (symbol >= slots_.size() || !slots_[symbol].declared)
+        {
+            return nullptr;
+        }
+        return &slots_[symbol].value;
+    }
+
+    // Declares variable symbol in scope, value can be presetted
+    // Returns reference on symbol in scope
+    VType &declare(token::symbol_t symbol, const VType &value = VType{})
+    {
+        if (symbol == token::SymbolTable::NO_SYMBOL)
+        {
+            throw std::invalid_argument("variable name is not interned");
+        }
+        if (symbol >= slots_.size())
+        {
+            slots_.resize(symbol + 1); // symbol table is not read, so names may be interned concurrently
+        }
+        slots_[symbol].declared = true;
+        return slots_[symbol].value = value;
+    }
+
+    // Returns if scope contains variable symbol
+    bool hasName(token::symbol_t symbol) const noexcept
+    {
+        return symbol < slots_.size() && slots_[symbol].declared;
+    }
+
+    // Returns VType that corresponds to varName
+    // If scope does not contain such varName, throws UnknownVariableError
+    VType &operator[](std::string_view varName)
+    {
+        return (*this)[symbols_->find(varName)];
     }
 
     // Declares variable varName in scope, value can be presetted
     // Returns reference on varName in scope
-    VType &declare(const std::string &varName, const VType &value = VType{})
+    VType &declare(std::string_view varName, const VType &value = VType{})
     {
-        return memory_[varName] = value;
+        return declare(symbols_->intern(varName), value);
     }
 
     // Returns if scope contains variable with name varName
-    bool hasName(const std::string &varName) const
+    bool hasName(std::string_view varName) const
     {
-        return memory_.find(varName) != memory_.end();
+        return hasName(symbols_->find(varName));
+    }
+
+    const std::shared_ptr<token::SymbolTable> &getSymbolTable() const noexcept
+    {
+        return symbols_;
     }
 
 private:
-    std::unordered_map<std::string, VType> memory_;
+    // Variable of symbol, its value and declaration flag share cache line
+    struct Slot
+    {
+        VType value{};
+        bool declared = false;
+    };
+
+    std::shared_ptr<token::SymbolTable> symbols_; // table of variable names
+    std::vector<Slot> slots_;                     // variable of each symbol
 };
 
 class Expression;
@@ -62,26 +124,12 @@ class Expression
 {
 public:
     // Evaluates all expression
-    // Returns [evaluation result; state]
+    // Returns evaluation result
     virtual VType eval(Scope &) = 0;
 
-    //
-    virtual void addExpressionFromNextIndentationLevel(ExprShPtr expr) = 0;
-
     virtual ~Expression() = default;
 };
 
-// Expression that does not need next level indentation block
-// For example: 'if' or 'while' does need it, 'let a = 0' does not
-class SingleIndentationLevelExpression : public Expression
-{
-public:
-    void addExpressionFromNextIndentationLevel(ExprShPtr) final
-    {
-        throw std::invalid_argument("SingleIndentationLevelExpression can not be extended with expression from next indentation level");
-    }
-};
-
 namespace details
 {
 // Function return type correct iff it returns VType
@@ -120,108 +168,30 @@ inline void checkOptionalNotEmptyOrThrow(const std::optional<T> &x,
 
 using PeachTuple = std::vector<VType>;
 
-// Any function or operator call in peach
-class FunctionCall : public SingleIndentationLevelExpression
-{
-public:
-    using FunctionType = std::function<VType(PeachTuple)>;
-
-    void setExpressions(const std::vector<ExprShPtr> &expressions) { expressions_.emplace(expressions); }
-    void setExpressions(std::vector<ExprShPtr> &&expressions) { expressions_.emplace(std::move(expressions)); }
-
-    void setFunction(const FunctionType &f) { f_.emplace(f); }
-    void setFunction(FunctionType &&f) { f_.emplace(std::move(f)); }
-
-    VType eval(Scope &scope) override
-    {
-        details::checkOptionalNotEmptyOrThrow(expressions_, "expression is not set yet");
-        details::checkOptionalNotEmptyOrThrow(f_, "function is not set yet");
-
-        PeachTuple callArgs;
-        for (std::size_t argId = 0; argId < expressions_.value().size(); ++argId)
-        {
-            callArgs.emplace_back(expressions_.value()[argId]->eval(scope));
-        }
-        auto res = f_.value()(callArgs);
-        return res;
-    }
-
-private:
-    std::optional<std::vector<ExprShPtr>> expressions_;
-    std::optional<FunctionType> f_;
-};
-
-// Value of type VType
-class VTypeValue : public SingleIndentationLevelExpression
+// Sequence of Expressions, evaluates in adding order
+class ExpressionSequence : public Expression
 {
 public:
-    VTypeValue(VType v = 0)
-        : value_(v) {}
-
-    void setValue(VType value) { value_ = value; }
-
-    VType eval(Scope &) override
+    // Adds expr to sequence
+    void addExpression(ExprShPtr expr)
     {
-        return value_;
+        exprs_.emplace_back(std::move(expr));
     }
 
-private:
-    VType value_;
-};
-
-// if/else conditional. if ifCond_ is true, evaluates ifWay_, elseWay_ otherwise
-class Conditional : public Expression
-{
-public:
-    Conditional(ExprShPtr ifCond)
-        : ifCond_(std::move(ifCond)) {}
-
-    void addExpressionFromNextIndentationLevel(ExprShPtr expr) override
+    // Replaces count expressions, starting from first one, with exprs
+    void replaceExpressions(std::size_t first, std::size_t count, std::vector<ExprShPtr> exprs)
     {
-        if (!ifWay_)
+        if (first + count > exprs_.size())
         {
-            ifWay_ = std::move(expr);
-        }
-        else if (!elseWay_)
-        {
-            elseWay_ = std::move(expr);
-        }
-        else
-        {
-            throw std::invalid_argument("Conditional is already has if and else ways");
+            throw std::out_of_range("replaced expressions are out of sequence");
         }
+        auto begin = exprs_.erase(exprs_.begin() + first, exprs_.begin() + first + count);
+        exprs_.insert(begin, std::make_move_iterator(exprs.begin()), std::make_move_iterator(exprs.end()));
     }
 
-    VType eval(Scope &scope) override
+    const std::vector<ExprShPtr> &getExpressions() const noexcept
     {
-        if (ifCond_->eval(scope))
-        {
-            auto result = VType{};
-            if (ifWay_)
-            {
-                result = ifWay_->eval(scope);
-            }
-            return result;
-        }
-        else if (elseWay_)
-        {
-            return elseWay_->eval(scope);
-        }
-        return VType{};
-    }
-
-private:
-    ExprShPtr ifCond_, ifWay_, elseWay_;
-};
-
-// Sequence of Expressions, evaluates in adding order
-class ExpressionSequence : public SingleIndentationLevelExpression
-{
-public:
-    // Adds expr to sequence
-    void addExpression(ExprShPtr expr)
-    {
-        exprs_.emplace_back(std::move(expr));
+        return exprs_;
     }
 
     VType eval(Scope &scope) override
@@ -236,130 +206,5 @@ public:
 private:
     std::vector<ExprShPtr> exprs_;
 };
-
-// while loop
-// while loopCond_ returns true loopBody_ evaluates
-class LoopWhile : public Expression
-{
-public:
-    LoopWhile(ExprShPtr cond)
-        : loopCond_(std::move(cond)) {}
-
-    void addExpressionFromNextIndentationLevel(ExprShPtr expr) override
-    {
-        if (loopBody_)
-        {
-            throw std::invalid_argument("loop while already has body");
-        }
-        loopBody_ = expr;
-    }
-
-    VType eval(Scope &scope) override
-    {
-        VType result{};
-        while (loopCond_->eval(scope))
-        {
-            result = loopBody_->eval(scope);
-        }
-        return result;
-    }
-
-private:
-    ExprShPtr loopCond_;
-    ExprShPtr loopBody_;
-};
-
-// Expression that contains variable
-class LvalueExpression : public SingleIndentationLevelExpression
-{
-public:
-    LvalueExpression(const std::string &name)
-        : varName_(name) {}
-
-    std::string getVariableName() const noexcept
-    {
-        return varName_;
-    }
-
-protected:
-    std::string varName_;
-};
-
-// Gives access to variable with name 'name'
-class VariableAccess : public LvalueExpression
-{
-public:
-    VariableAccess(const std::string &name)
-        : LvalueExpression(name) {}
-
-    VType eval(Scope &scope) override
-    {
-        if (!scope.hasName(varName_))
-        {
-            exception::throwFromCoords<exception::UnknownVariableError>(111, 222); // Expression must know its position
-        }
-        return scope[varName_];
-    }
-};
-
-// Declares variable with name 'name'
-class VariableDeclaration : public LvalueExpression
-{
-public:
-    VariableDeclaration(const std::string &name)
-        : LvalueExpression(name) {}
-
-    VType eval(Scope &scope) override
-    {
-        if (scope.hasName(varName_))
-        {
-            exception::throwFromCoords<exception::VariableRedeclaration>(0, 0); // Expression must know its position
-        }
-        return scope.declare(varName_);
-    }
-};
-
-// Assigns left expression to right.
-// Can be constructed iff left expression is LvalueExpression
-class AssignExpression : public SingleIndentationLevelExpression
-{
-public:
-    using FunctionType = std::function<void(VType &, VType)>;
-
-    AssignExpression(
-        ExprShPtr left,
-        ExprShPtr right,
-        FunctionType functor)
-        : functor_(std::move(functor))
-    {
-        if (!left || !right)
-        {
-            throw std::invalid_argument("nullptr expression in AssignExpression constructor");
-        }
-        left_ = std::dynamic_pointer_cast<LvalueExpression>(left);
-        if (!left_)
-        {
-            exception::throwFromCoords<exception::InvalidAssignationError>(0, 0); // TODO: expression must know its position
-        }
-        right_ = std::move(right);
-    }
-
-    VType eval(Scope &scope) override
-    {
-        if (!left_ || !right_)
-        {
-            throw std::invalid_argument("AssignExpression does not have expression yet");
-        }
-        VType rightEvalRes = right_->eval(scope);
-        VType &leftVariable = scope[left_->getVariableName()];
-        functor_(leftVariable, rightEvalRes);
-        return leftVariable;
-    }
-
-private:
-    std::shared_ptr<LvalueExpression> left_;
-    ExprShPtr right_;
-    FunctionType functor_;
-};
 } // namespace expression
 } // namespace peach
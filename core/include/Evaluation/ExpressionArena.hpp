@@ -0,0 +1,501 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Exception.hpp"
+#include "Expression.hpp"
+#include "Operators.hpp"
+#include "SymbolTable.hpp"
+
+namespace peach
+{
+namespace expression
+{
+// Index of node in ExpressionArena
+using node_t = std::uint32_t;
+
+// Function of unary or binary operator
+using CallFunction = std::function<VType(PeachTuple)>;
+
+// Function of assignment operator, such as simple assignation '=' or '+='
+using AssignFunction = std::function<void(VType &, VType)>;
+
+// Functions of operators, nodes refer to them by index
+// Operator with builtin kind other than NONE is evaluated inline, its function is used by generic calls only
+// Table is shared by all arenas of interpreter and is not changed after construction
+struct OperatorFunctions
+{
+    std::vector<CallFunction> calls;
+    std::vector<AssignFunction> assignments;
+    std::vector<BuiltinOperator> callBuiltins;
+    std::vector<BuiltinOperator> assignmentBuiltins;
+};
+
+// Nodes of expressions of compiled program, which are stored in a single vector and refer to each other by index
+// Nodes are appended after their operands, so they are laid out in evaluation order.
+// Sequences keep their expressions in shared children list. All nodes are freed with arena at once.
+// Appending nodes does not invalidate indices, so expressions of arena stay valid while it grows.
+class ExpressionArena
+{
+public:
+    static constexpr node_t NO_NODE = std::numeric_limits<node_t>::max();
+
+    enum class NodeKind : std::uint8_t
+    {
+        VALUE,                // first is value
+        VARIABLE_ACCESS,      // first is symbol
+        VARIABLE_DECLARATION, // first is symbol
+        CALL,                 // first and second are operands (second is NO_NODE for unary call), third is function
+        ASSIGN,               // first is symbol, second is right operand, third is function
+        CONDITIONAL,          // first is condition, second is if way, third is else way or NO_NODE
+        LOOP_WHILE,           // first is condition, second is body
+        SEQUENCE,             // first is offset of expressions in children list, second is their count
+
+        // Builtin operators in order of BuiltinOperator, fields are the same as fields of CALL or ASSIGN
+        NOT,
+        POW,
+        MUL,
+        DIV,
+        MOD,
+        ADD,
+        SUB,
+        EQUAL,
+        NOT_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        OR,
+        AND,
+        ASSIGN_BUILTIN,
+        ADD_ASSIGN,
+        SUB_ASSIGN,
+        MUL_ASSIGN,
+        DIV_ASSIGN,
+        MOD_ASSIGN,
+        AND_ASSIGN,
+        OR_ASSIGN,
+    };
+
+    // Returns kind of node of builtin operator
+    static constexpr NodeKind getBuiltinKind(BuiltinOperator op) noexcept
+    {
+        return static_cast<NodeKind>(static_cast<std::uint8_t>(NodeKind::NOT) + static_cast<std::uint8_t>(op));
+    }
+
+    // Node is 16 bytes, meaning of fields depends on kind
+    struct Node
+    {
+        NodeKind kind;
+        std::uint32_t first;
+        std::uint32_t second;
+        std::uint32_t third;
+    };
+
+    explicit ExpressionArena(std::shared_ptr<const OperatorFunctions> functions)
+        : functions_(std::move(functions))
+    {
+        if (!functions_)
+        {
+            throw std::invalid_argument("nullptr operator functions in ExpressionArena constructor");
+        }
+    }
+
+    node_t addValue(VType value)
+    {
+        return addNode(NodeKind::VALUE, static_cast<std::uint32_t>(value));
+    }
+
+    node_t addVariableAccess(token::symbol_t symbol)
+    {
+        return addNode(NodeKind::VARIABLE_ACCESS, checkSymbol(symbol));
+    }
+
+    node_t addVariableDeclaration(token::symbol_t symbol)
+    {
+        return addNode(NodeKind::VARIABLE_DECLARATION, checkSymbol(symbol));
+    }
+
+    // Adds call of function with one or two operands
+    // Call of builtin operator of the same arity gets its own node kind, generic call node is added otherwise
+    node_t addCall(std::size_t function, node_t left, node_t right = NO_NODE)
+    {
+        if (function >= functions_->calls.size() || !functions_->calls[function])
+        {
+            throw std::invalid_argument("can not find operator function");
+        }
+        NodeKind kind = NodeKind::CALL;
+        BuiltinOperator builtin = getBuiltin(functions_->callBuiltins, function);
+        if (builtin != BuiltinOperator::NONE && getArity(builtin) == (right == NO_NODE ? 1 : 2))
+        {
+            kind = getBuiltinKind(builtin);
+        }
+        return addNode(kind, checkNode(left), right == NO_NODE ? NO_NODE : checkNode(right), static_cast<std::uint32_t>(function));
+    }
+
+    // Adds assignment of right expression to variable of left one
+    // Throws InvalidAssignationError, if left expression is not variable access
+    node_t addAssignment(std::size_t function, node_t left, node_t right)
+    {
+        if (function >= functions_->assignments.size() || !functions_->assignments[function])
+        {
+            throw std::invalid_argument("can not find assignment operator function");
+        }
+        if (nodes_[checkNode(left)].kind != NodeKind::VARIABLE_ACCESS)
+        {
+            exception::throwFromCoords<exception::InvalidAssignationError>(0, 0); // TODO: expression must know its position
+        }
+        NodeKind kind = NodeKind::ASSIGN;
+        BuiltinOperator builtin = getBuiltin(functions_->assignmentBuiltins, function);
+        if (builtin != BuiltinOperator::NONE && getArity(builtin) == 0)
+        {
+            kind = getBuiltinKind(builtin);
+        }
+        return addNode(kind, nodes_[left].first, checkNode(right), static_cast<std::uint32_t>(function));
+    }
+
+    // Adds if/else conditional, elseWay may be NO_NODE
+    node_t addConditional(node_t condition, node_t ifWay, node_t elseWay = NO_NODE)
+    {
+        return addNode(NodeKind::CONDITIONAL, checkNode(condition), checkNode(ifWay), elseWay == NO_NODE ? NO_NODE : checkNode(elseWay));
+    }
+
+    node_t addLoopWhile(node_t condition, node_t body)
+    {
+        return addNode(NodeKind::LOOP_WHILE, checkNode(condition), checkNode(body));
+    }
+
+    // Adds sequence of expressions, which evaluates in order
+    node_t addSequence(const std::vector<node_t> &expressions)
+    {
+        if (children_.size() + expressions.size() > NO_NODE)
+        {
+            throw std::length_error("too many nodes in expression arena");
+        }
+        auto offset = static_cast<std::uint32_t>(children_.size());
+        for (node_t expression : expressions)
+        {
+            children_.push_back(checkNode(expression));
+        }
+        return addNode(NodeKind::SEQUENCE, offset, static_cast<std::uint32_t>(expressions.size()));
+    }
+
+    // Appends all nodes of other arena, it must share operator functions with this one
+    // Returns offset of its nodes: node of other arena gets index node + offset in this one
+    node_t append(const ExpressionArena &other)
+    {
+        if (other.functions_ != functions_)
+        {
+            throw std::invalid_argument("appended arena has other operator functions");
+        }
+        if (nodes_.size() + other.nodes_.size() > NO_NODE || children_.size() + other.children_.size() > NO_NODE)
+        {
+            throw std::length_error("too many nodes in expression arena");
+        }
+        auto offset = static_cast<node_t>(nodes_.size());
+        auto childrenOffset = static_cast<std::uint32_t>(children_.size());
+        auto relocate = [offset](node_t node) { return node == NO_NODE ? NO_NODE : node + offset; };
+        nodes_.reserve(nodes_.size() + other.nodes_.size());
+        for (Node node : other.nodes_)
+        {
+            switch (node.kind)
+            {
+            case NodeKind::VALUE:
+            case NodeKind::VARIABLE_ACCESS:
+            case NodeKind::VARIABLE_DECLARATION:
+                break;
+            case NodeKind::CALL:
+            case NodeKind::LOOP_WHILE:
+                node.first = relocate(node.first);
+                node.second = relocate(node.second);
+                break;
+            case NodeKind::ASSIGN:
+                node.second = relocate(node.second);
+                break;
+            case NodeKind::CONDITIONAL:
+                node.first = relocate(node.first);
+                node.second = relocate(node.second);
+                node.third = relocate(node.third);
+                break;
+            case NodeKind::SEQUENCE:
+                node.first += childrenOffset;
+                break;
+            default:
+                if (isAssignment(node.kind))
+                {
+                    node.second = relocate(node.second);
+                }
+                else
+                {
+                    node.first = relocate(node.first);
+                    node.second = relocate(node.second);
+                }
+                break;
+            }
+            nodes_.push_back(node);
+        }
+        for (node_t child : other.children_)
+        {
+            children_.push_back(child + offset);
+        }
+        return offset;
+    }
+
+    // Evaluates expression of node
+    VType eval(node_t node, Scope &scope) const
+    {
+        const Node &current = nodes_[node];
+        switch (current.kind)
+        {
+        case NodeKind::VALUE:
+            return static_cast<VType>(current.first);
+
+        case NodeKind::VARIABLE_ACCESS:
+        {
+            const VType *value = scope.find(current.first);
+            if (!value)
+            {
+                exception::throwFromCoords<exception::UnknownVariableError>(111, 222); // Expression must know its position
+            }
+            return *value;
+        }
+
+        case NodeKind::VARIABLE_DECLARATION:
+            if (scope.hasName(current.first))
+            {
+                exception::throwFromCoords<exception::VariableRedeclaration>(0, 0); // Expression must know its position
+            }
+            return scope.declare(current.first);
+
+        case NodeKind::CALL:
+        {
+            PeachTuple args{eval(current.first, scope)};
+            if (current.second != NO_NODE)
+            {
+                args.push_back(eval(current.second, scope));
+            }
+            return functions_->calls[current.third](std::move(args));
+        }
+
+        case NodeKind::ASSIGN:
+            return evalAssignment(current, scope, functions_->assignments[current.third]);
+
+        case NodeKind::CONDITIONAL:
+            if (eval(current.first, scope))
+            {
+                return eval(current.second, scope);
+            }
+            return current.third != NO_NODE ? eval(current.third, scope) : VType{};
+
+        case NodeKind::LOOP_WHILE:
+        {
+            VType result{};
+            while (eval(current.first, scope))
+            {
+                result = eval(current.second, scope);
+            }
+            return result;
+        }
+
+        case NodeKind::SEQUENCE:
+        {
+            VType result{};
+            for (std::uint32_t child = current.first; child < current.first + current.second; ++child)
+            {
+                result = eval(children_[child], scope);
+            }
+            return result;
+        }
+
+        case NodeKind::NOT:
+            return operators::Not()(eval(current.first, scope));
+        case NodeKind::POW:
+            return evalBinary<operators::Pow>(current, scope);
+        case NodeKind::MUL:
+            return evalBinary<operators::Mul>(current, scope);
+        case NodeKind::DIV:
+            return evalBinary<operators::Div>(current, scope);
+        case NodeKind::MOD:
+            return evalBinary<operators::Mod>(current, scope);
+        case NodeKind::ADD:
+            return evalBinary<operators::Add>(current, scope);
+        case NodeKind::SUB:
+            return evalBinary<operators::Sub>(current, scope);
+        case NodeKind::EQUAL:
+            return evalBinary<operators::Equal>(current, scope);
+        case NodeKind::NOT_EQUAL:
+            return evalBinary<operators::NotEqual>(current, scope);
+        case NodeKind::GREATER:
+            return evalBinary<operators::Greater>(current, scope);
+        case NodeKind::GREATER_EQUAL:
+            return evalBinary<operators::GreaterEqual>(current, scope);
+        case NodeKind::LESS:
+            return evalBinary<operators::Less>(current, scope);
+        case NodeKind::LESS_EQUAL:
+            return evalBinary<operators::LessEqual>(current, scope);
+        case NodeKind::OR:
+            return evalBinary<operators::Or>(current, scope);
+        case NodeKind::AND:
+            return evalBinary<operators::And>(current, scope);
+        case NodeKind::ASSIGN_BUILTIN:
+            return evalAssignment(current, scope, operators::Assign());
+        case NodeKind::ADD_ASSIGN:
+            return evalAssignment(current, scope, operators::AddAssign());
+        case NodeKind::SUB_ASSIGN:
+            return evalAssignment(current, scope, operators::SubAssign());
+        case NodeKind::MUL_ASSIGN:
+            return evalAssignment(current, scope, operators::MulAssign());
+        case NodeKind::DIV_ASSIGN:
+            return evalAssignment(current, scope, operators::DivAssign());
+        case NodeKind::MOD_ASSIGN:
+            return evalAssignment(current, scope, operators::ModAssign());
+        case NodeKind::AND_ASSIGN:
+            return evalAssignment(current, scope, operators::AndAssign());
+        case NodeKind::OR_ASSIGN:
+            return evalAssignment(current, scope, operators::OrAssign());
+        }
+        throw std::logic_error("unknown expression node kind");
+    }
+
+    // Returns if node of kind assigns variable, its first field is symbol then
+    static constexpr bool isAssignment(NodeKind kind) noexcept
+    {
+        return kind == NodeKind::ASSIGN || (kind >= NodeKind::ASSIGN_BUILTIN && kind <= NodeKind::OR_ASSIGN);
+    }
+
+    const Node &getNode(node_t node) const
+    {
+        return nodes_[checkNode(node)];
+    }
+
+    // Returns expression of sequence by index in children list, sequence node keeps offset of its expressions
+    node_t getChild(std::uint32_t index) const
+    {
+        if (index >= children_.size())
+        {
+            throw std::out_of_range("child does not exist in expression arena");
+        }
+        return children_[index];
+    }
+
+    const std::shared_ptr<const OperatorFunctions> &getFunctions() const noexcept
+    {
+        return functions_;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return nodes_.size();
+    }
+
+    // Reserves space for nodes, so they are appended without reallocation
+    void reserve(std::size_t nodes)
+    {
+        nodes_.reserve(nodes);
+    }
+
+private:
+    // Evaluates both operands of binary operator, left one first, and applies operator to them
+    template <typename OperatorT>
+    VType evalBinary(const Node &node, Scope &scope) const
+    {
+        VType left = eval(node.first, scope);
+        return OperatorT()(left, eval(node.second, scope));
+    }
+
+    // Evaluates right operand and assigns it to variable with assignment operator
+    template <typename AssignT>
+    VType evalAssignment(const Node &node, Scope &scope, const AssignT &assign) const
+    {
+        VType right = eval(node.second, scope);
+        VType *left = scope.find(node.first);
+        if (!left)
+        {
+            exception::throwFromCoords<exception::UnknownVariableError>(0, 0);
+        }
+        assign(*left, right);
+        return *left;
+    }
+
+    static BuiltinOperator getBuiltin(const std::vector<BuiltinOperator> &builtins, std::size_t function) noexcept
+    {
+        return function < builtins.size() ? builtins[function] : BuiltinOperator::NONE;
+    }
+
+    node_t addNode(NodeKind kind, std::uint32_t first, std::uint32_t second = NO_NODE, std::uint32_t third = NO_NODE)
+    {
+        if (nodes_.size() >= NO_NODE)
+        {
+            throw std::length_error("too many nodes in expression arena");
+        }
+        nodes_.push_back(Node{kind, first, second, third});
+        return static_cast<node_t>(nodes_.size() - 1);
+    }
+
+    node_t checkNode(node_t node) const
+    {
+        if (node >= nodes_.size())
+        {
+            throw std::out_of_range("node does not exist in expression arena");
+        }
+        return node;
+    }
+
+    static token::symbol_t checkSymbol(token::symbol_t symbol)
+    {
+        if (symbol == token::SymbolTable::NO_SYMBOL)
+        {
+            throw std::invalid_argument("variable name is not interned");
+        }
+        return symbol;
+    }
+
+    std::vector<Node> nodes_;                            // nodes in adding order
+    std::vector<node_t> children_;                       // expressions of sequences
+    std::shared_ptr<const OperatorFunctions> functions_; // functions of call and assign nodes
+};
+
+static_assert(ExpressionArena::getBuiltinKind(BuiltinOperator::OR_ASSIGN) == ExpressionArena::NodeKind::OR_ASSIGN,
+              "builtin node kinds must follow BuiltinOperator");
+
+// Expression of node in arena, arena is kept alive while expression exists
+class ArenaExpression : public Expression
+{
+public:
+    ArenaExpression(std::shared_ptr<const ExpressionArena> arena, node_t root)
+        : arena_(std::move(arena)),
+          root_(root)
+    {
+        if (!arena_)
+        {
+            throw std::invalid_argument("nullptr arena in ArenaExpression constructor");
+        }
+        arena_->getNode(root_);
+    }
+
+    VType eval(Scope &scope) override
+    {
+        return arena_->eval(root_, scope);
+    }
+
+    const std::shared_ptr<const ExpressionArena> &getArena() const noexcept
+    {
+        return arena_;
+    }
+
+    node_t getRoot() const noexcept
+    {
+        return root_;
+    }
+
+private:
+    std::shared_ptr<const ExpressionArena> arena_;
+    node_t root_;
+};
+} // namespace expression
+} // namespace peach
@@ -0,0 +1,682 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "Bytecode.hpp"
+#include "CodeCache.hpp"
+#include "Expression.hpp"
+#include "Operators.hpp"
+#include "X86Emitter.hpp"
+
+// Loops are compiled to native code on x86-64 with executable memory, unless PEACH_NO_JIT is defined
+#if defined(__x86_64__) && defined(PEACH_CODE_CACHE_SUPPORTED) && !defined(PEACH_NO_JIT)
+#define PEACH_JIT_SUPPORTED
+#endif
+
+namespace peach
+{
+namespace expression
+{
+// Compiles hot while loops of bytecode program to x86-64 code, runs them instead of virtual machine
+// Loop is compiled, when it passes threshold of iterations. Its variables are kept in registers,
+// generic operators and ** are called back, zero or -1 divisor returns to virtual machine before division,
+// so virtual machine reports ZeroDivisionError. Loops, which declare variables, are not compiled.
+// Compiled loops of the last MAX_PROGRAMS run programs are kept, so program, which is run again, starts hot.
+class LoopJit : public LoopAccelerator
+{
+public:
+    // Iterations of loop in virtual machine before its compilation
+    static constexpr std::uint32_t HOT_LOOP_ITERATIONS = 1000;
+
+    // Programs, which iterations and compiled loops are kept, code of older ones is removed
+    static constexpr std::size_t MAX_PROGRAMS = 16;
+
+    // Returns if loops can be compiled on this platform, else all loops are run by virtual machine
+    static constexpr bool isSupported() noexcept
+    {
+#ifdef PEACH_JIT_SUPPORTED
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    explicit LoopJit(std::uint32_t threshold = HOT_LOOP_ITERATIONS)
+        : threshold_(threshold)
+    {
+    }
+
+    std::uint32_t runLoop(const BytecodeProgram &program, std::uint32_t loop, VType *stack, Scope &scope) override
+    {
+        CompiledLoop &compiled = getLoops(program).at(loop);
+        if (!compiled.code)
+        {
+            if (compiled.failed || ++compiled.iterations < threshold_)
+            {
+                return NO_ADDRESS;
+            }
+            compile(program, loop, compiled);
+            if (!compiled.code)
+            {
+                return NO_ADDRESS;
+            }
+        }
+
+        // Loop does not declare variables, so they are declared before it or it is run by virtual machine
+        values_.resize(compiled.variables.size());
+        frame_.resize(compiled.variables.size());
+        for (std::size_t i = 0; i < compiled.variables.size(); ++i)
+        {
+            values_[i] = scope.find(compiled.variables[i]);
+            if (!values_[i])
+            {
+                return NO_ADDRESS;
+            }
+            frame_[i] = *values_[i];
+        }
+        Context context{stack, frame_.data(), &program, nullptr};
+        std::uint32_t next = compiled.code(&context);
+        for (std::size_t i = 0; i < compiled.variables.size(); ++i)
+        {
+            *values_[i] = frame_[i];
+        }
+        if (next == EXCEPTION_ADDRESS)
+        {
+            std::rethrow_exception(context.error);
+        }
+        return next;
+    }
+
+    // Returns number of loops, which are compiled to native code
+    std::size_t getCompiledLoops() const noexcept
+    {
+        std::size_t count = 0;
+        for (const auto &program : programs_)
+        {
+            for (const auto &loop : program.loops)
+            {
+                count += loop.code != nullptr;
+            }
+        }
+        return count;
+    }
+
+private:
+    // Native code returns it, if called back operator throws exception
+    static constexpr std::uint32_t EXCEPTION_ADDRESS = NO_ADDRESS - 1;
+
+    // State of native code: stack of virtual machine and frame of loop variables
+    struct Context
+    {
+        VType *stack;
+        VType *frame;
+        const BytecodeProgram *program;
+        std::exception_ptr error;
+    };
+
+    // Native code returns address, where virtual machine continues
+    using NativeLoop = std::uint32_t (*)(Context *);
+
+    struct CompiledLoop
+    {
+        NativeLoop code = nullptr;
+        std::vector<token::symbol_t> variables; // symbols of frame variables
+        std::uint32_t iterations = 0;           // iterations in virtual machine
+        bool failed = false;                    // loop can not be compiled
+    };
+
+    // Loops of program with id
+    struct ProgramLoops
+    {
+        std::uint64_t id;
+        std::vector<CompiledLoop> loops;
+    };
+
+    // Returns loops of program, it becomes the last run one
+    // The least recently run program is forgotten, if there are too many of them
+    std::vector<CompiledLoop> &getLoops(const BytecodeProgram &program)
+    {
+        if (!programs_.empty() && programs_.back().id == program.getId())
+        {
+            return programs_.back().loops;
+        }
+        auto found = std::find_if(programs_.begin(), programs_.end(), [&](const ProgramLoops &candidate) {
+            return candidate.id == program.getId();
+        });
+        if (found != programs_.end())
+        {
+            std::rotate(found, found + 1, programs_.end());
+            return programs_.back().loops;
+        }
+        if (programs_.size() == MAX_PROGRAMS)
+        {
+            for (const auto &loop : programs_.front().loops)
+            {
+                if (loop.code)
+                {
+                    cache_.remove(reinterpret_cast<const void *>(loop.code));
+                }
+            }
+            programs_.erase(programs_.begin());
+        }
+        programs_.push_back({program.getId(), std::vector<CompiledLoop>(program.getLoops().size())});
+        return programs_.back().loops;
+    }
+
+#ifdef PEACH_JIT_SUPPORTED
+    using X86 = tools::X86Emitter;
+
+    static constexpr std::uint32_t STACK_REGISTERS_COUNT = 6;
+    static constexpr std::uint32_t VARIABLE_REGISTERS_COUNT = 4;
+
+    // Registers of stack values from loop stack base, rax, rcx and rdx are scratch
+    static constexpr X86::Register STACK_REGISTERS[STACK_REGISTERS_COUNT] = {X86::RSI, X86::RDI, X86::R8, X86::R9, X86::R10, X86::R11};
+
+    // Registers of the first frame variables, the other variables are in frame, rbx points to frame
+    static constexpr X86::Register VARIABLE_REGISTERS[VARIABLE_REGISTERS_COUNT] = {X86::R12, X86::R13, X86::R14, X86::R15};
+
+    // Callee saved registers, which native code uses, rbp points to context
+    static constexpr X86::Register SAVED_REGISTERS[] = {X86::RBX, X86::RBP, X86::R12, X86::R13, X86::R14, X86::R15};
+
+    // Executes instruction at address with operands on stack of depth, variable is frame index of assigned variable
+    // Returns 1 and keeps exception in context, if operator throws
+    static int callBack(Context *context, std::uint32_t address, std::uint32_t depth, std::uint32_t variable) noexcept
+    {
+        try
+        {
+            const Instruction &instruction = context->program->getInstructions()[address];
+            const OperatorFunctions &functions = context->program->getFunctions();
+            VType *top = context->stack + depth;
+            switch (instruction.op)
+            {
+            case Opcode::CALL_UNARY:
+                top[-1] = functions.calls[instruction.function](PeachTuple{top[-1]});
+                break;
+            case Opcode::CALL_BINARY:
+                top[-2] = functions.calls[instruction.function](PeachTuple{top[-2], top[-1]});
+                break;
+            case Opcode::POW:
+                top[-2] = operators::Pow()(top[-2], top[-1]);
+                break;
+            case Opcode::ASSIGN:
+                functions.assignments[instruction.function](context->frame[variable], top[-1]);
+                top[-1] = context->frame[variable];
+                break;
+            default:
+                throw std::logic_error("operation is not called back");
+            }
+            return 0;
+        }
+        catch (...)
+        {
+            context->error = std::current_exception();
+            return 1;
+        }
+    }
+
+    // Emits native code of single loop
+    class LoopCompiler
+    {
+    public:
+        LoopCompiler(const BytecodeProgram &program, LoopInfo loop)
+            : program_(program)
+            , code_(program.getInstructions())
+            , loop_(loop)
+            , base_(program.getStackDepth(loop.header) - 1) // result of previous iteration is popped in loop
+        {
+        }
+
+        // Returns if loop can be compiled, collects its variables
+        bool check()
+        {
+            for (std::uint32_t address = loop_.header; address < loop_.end; ++address)
+            {
+                const Instruction &instruction = code_[address];
+                std::uint32_t pushed = instruction.op == Opcode::PUSH || instruction.op == Opcode::LOAD;
+                if (instruction.op == Opcode::DECLARE || instruction.op == Opcode::HALT ||
+                    program_.getStackDepth(address) < base_ || getRelativeDepth(address) + pushed > STACK_REGISTERS_COUNT)
+                {
+                    return false;
+                }
+                if (isJump(instruction.op) && (instruction.arg < loop_.header || instruction.arg > loop_.end))
+                {
+                    return false;
+                }
+                if (usesVariable(instruction.op))
+                {
+                    addVariable(instruction.arg);
+                }
+            }
+            return true;
+        }
+
+        // Returns code of function, which runs loop from its header
+        std::vector<std::uint8_t> compile()
+        {
+            labels_.clear();
+            for (std::uint32_t address = loop_.header; address <= loop_.end; ++address)
+            {
+                labels_.push_back(x86_.makeLabel());
+            }
+            exceptionLabel_ = x86_.makeLabel();
+
+            for (X86::Register reg : SAVED_REGISTERS)
+            {
+                x86_.push(reg);
+            }
+            x86_.subRsp(8); // stack is aligned by 16 at calls
+            x86_.mov64(X86::RBP, X86::RDI);
+            x86_.load64(X86::RBX, X86::RBP, offsetof(Context, frame));
+            loadVariables();
+            loadStack(getRelativeDepth(loop_.header));
+
+            for (std::uint32_t address = loop_.header; address < loop_.end; ++address)
+            {
+                x86_.bind(getLabel(address));
+                compileInstruction(address);
+            }
+
+            x86_.bind(getLabel(loop_.end));
+            emitExit(loop_.end, getRelativeDepth(loop_.end));
+            for (const auto &deoptimization : deoptimizations_)
+            {
+                x86_.bind(deoptimization.label);
+                emitExit(deoptimization.address, getRelativeDepth(deoptimization.address));
+            }
+            x86_.bind(exceptionLabel_);
+            emitExit(EXCEPTION_ADDRESS, 0);
+            return x86_.finish();
+        }
+
+        const std::vector<token::symbol_t> &getVariables() const noexcept
+        {
+            return variables_;
+        }
+
+    private:
+        // Place, where native code returns to virtual machine before instruction
+        struct Deoptimization
+        {
+            X86::Label label;
+            std::uint32_t address;
+        };
+
+        static bool isJump(Opcode op) noexcept
+        {
+            return op == Opcode::JUMP || op == Opcode::JUMP_IF_FALSE || op == Opcode::LOOP;
+        }
+
+        static bool usesVariable(Opcode op) noexcept
+        {
+            return op == Opcode::LOAD || op == Opcode::ASSIGN || op >= Opcode::ASSIGN_BUILTIN;
+        }
+
+        void addVariable(token::symbol_t symbol)
+        {
+            for (const auto variable : variables_)
+            {
+                if (variable == symbol)
+                {
+                    return;
+                }
+            }
+            variables_.push_back(symbol);
+        }
+
+        std::uint32_t getVariable(token::symbol_t symbol) const
+        {
+            for (std::uint32_t i = 0; i < variables_.size(); ++i)
+            {
+                if (variables_[i] == symbol)
+                {
+                    return i;
+                }
+            }
+            throw std::logic_error("variable of loop is not collected");
+        }
+
+        // Returns number of stack values in registers before instruction
+        std::uint32_t getRelativeDepth(std::uint32_t address) const
+        {
+            return program_.getStackDepth(address) - base_;
+        }
+
+        X86::Label getLabel(std::uint32_t address) const
+        {
+            return labels_[address - loop_.header];
+        }
+
+        static std::int32_t getFrameOffset(std::uint32_t variable) noexcept
+        {
+            return static_cast<std::int32_t>(variable * sizeof(VType));
+        }
+
+        std::int32_t getStackOffset(std::uint32_t index) const noexcept
+        {
+            return static_cast<std::int32_t>((base_ + index) * sizeof(VType));
+        }
+
+        static bool inRegister(std::uint32_t variable) noexcept
+        {
+            return variable < VARIABLE_REGISTERS_COUNT;
+        }
+
+        void loadVariable(X86::Register dst, std::uint32_t variable)
+        {
+            if (inRegister(variable))
+            {
+                x86_.mov(dst, VARIABLE_REGISTERS[variable]);
+            }
+            else
+            {
+                x86_.load(dst, X86::RBX, getFrameOffset(variable));
+            }
+        }
+
+        void storeVariable(std::uint32_t variable, X86::Register src)
+        {
+            if (inRegister(variable))
+            {
+                x86_.mov(VARIABLE_REGISTERS[variable], src);
+            }
+            else
+            {
+                x86_.store(X86::RBX, getFrameOffset(variable), src);
+            }
+        }
+
+        // Moves variables from frame to registers
+        void loadVariables()
+        {
+            for (std::uint32_t i = 0; i < variables_.size() && inRegister(i); ++i)
+            {
+                x86_.load(VARIABLE_REGISTERS[i], X86::RBX, getFrameOffset(i));
+            }
+        }
+
+        // Moves variables from registers to frame
+        void storeVariables()
+        {
+            for (std::uint32_t i = 0; i < variables_.size() && inRegister(i); ++i)
+            {
+                x86_.store(X86::RBX, getFrameOffset(i), VARIABLE_REGISTERS[i]);
+            }
+        }
+
+        // Moves count stack values from virtual machine stack to registers
+        void loadStack(std::uint32_t count)
+        {
+            x86_.load64(X86::RAX, X86::RBP, offsetof(Context, stack));
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                x86_.load(STACK_REGISTERS[i], X86::RAX, getStackOffset(i));
+            }
+        }
+
+        // Moves count stack values from registers to virtual machine stack
+        void storeStack(std::uint32_t count)
+        {
+            x86_.load64(X86::RAX, X86::RBP, offsetof(Context, stack));
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                x86_.store(X86::RAX, getStackOffset(i), STACK_REGISTERS[i]);
+            }
+        }
+
+        // Returns to virtual machine at address with stack of size depth
+        void emitExit(std::uint32_t address, std::uint32_t depth)
+        {
+            storeStack(depth);
+            storeVariables();
+            x86_.mov(X86::RAX, static_cast<std::int32_t>(address));
+            x86_.addRsp(8);
+            for (std::size_t i = std::size(SAVED_REGISTERS); i-- > 0;)
+            {
+                x86_.pop(SAVED_REGISTERS[i]);
+            }
+            x86_.ret();
+        }
+
+        // Returns to virtual machine before instruction at address, if divisor is 0 or -1
+        void guardDivisor(X86::Register divisor, std::uint32_t address)
+        {
+            X86::Label label = x86_.makeLabel();
+            deoptimizations_.push_back({label, address});
+            x86_.cmp(divisor, std::int8_t{0});
+            x86_.jcc(X86::EQUAL, label);
+            x86_.cmp(divisor, std::int8_t{-1});
+            x86_.jcc(X86::EQUAL, label);
+        }
+
+        // Executes instruction at address by callBack with values from registers
+        void emitCallBack(std::uint32_t address)
+        {
+            const Instruction &instruction = code_[address];
+            bool assignment = instruction.op == Opcode::ASSIGN;
+            std::uint32_t variable = assignment ? getVariable(instruction.arg) : 0;
+            storeStack(getRelativeDepth(address));
+            if (assignment && inRegister(variable))
+            {
+                x86_.store(X86::RBX, getFrameOffset(variable), VARIABLE_REGISTERS[variable]);
+            }
+            x86_.mov64(X86::RDI, X86::RBP);
+            x86_.mov(X86::RSI, static_cast<std::int32_t>(address));
+            x86_.mov(X86::RDX, static_cast<std::int32_t>(program_.getStackDepth(address)));
+            x86_.mov(X86::RCX, static_cast<std::int32_t>(variable));
+            x86_.mov64(X86::RAX, reinterpret_cast<std::uint64_t>(&LoopJit::callBack));
+            x86_.call(X86::RAX);
+            x86_.test(X86::RAX, X86::RAX);
+            x86_.jcc(X86::NOT_EQUAL, exceptionLabel_);
+            if (assignment && inRegister(variable))
+            {
+                x86_.load(VARIABLE_REGISTERS[variable], X86::RBX, getFrameOffset(variable));
+            }
+            loadStack(getRelativeDepth(address + 1));
+        }
+
+        void compileComparison(X86::Register left, X86::Register right, X86::Condition condition)
+        {
+            x86_.cmp(left, right);
+            x86_.setAl(condition);
+            x86_.movzxAl(left);
+        }
+
+        void compileDivision(std::uint32_t address, X86::Register left, X86::Register right, bool remainder)
+        {
+            guardDivisor(right, address);
+            x86_.mov(X86::RAX, left);
+            x86_.cdq();
+            x86_.idiv(right);
+            x86_.mov(left, remainder ? X86::RDX : X86::RAX);
+        }
+
+        // Applies assignment operator to variable, top becomes value of variable
+        void compileAssignment(std::uint32_t address, std::uint32_t variable, X86::Register top)
+        {
+            Opcode op = code_[address].op;
+            if (op == Opcode::ASSIGN_BUILTIN)
+            {
+                storeVariable(variable, top);
+                return;
+            }
+            if (op == Opcode::DIV_ASSIGN || op == Opcode::MOD_ASSIGN)
+            {
+                guardDivisor(top, address);
+                loadVariable(X86::RAX, variable);
+                x86_.cdq();
+                x86_.idiv(top);
+                X86::Register result = op == Opcode::DIV_ASSIGN ? X86::RAX : X86::RDX;
+                storeVariable(variable, result);
+                x86_.mov(top, result);
+                return;
+            }
+            X86::Register left = inRegister(variable) ? VARIABLE_REGISTERS[variable] : X86::RAX;
+            if (!inRegister(variable))
+            {
+                loadVariable(left, variable);
+            }
+            switch (op)
+            {
+            case Opcode::ADD_ASSIGN:
+                x86_.add(left, top);
+                break;
+            case Opcode::SUB_ASSIGN:
+                x86_.sub(left, top);
+                break;
+            case Opcode::MUL_ASSIGN:
+                x86_.imul(left, top);
+                break;
+            case Opcode::AND_ASSIGN:
+                x86_.bitAnd(left, top);
+                break;
+            case Opcode::OR_ASSIGN:
+                x86_.bitOr(left, top);
+                break;
+            default:
+                throw std::logic_error("unknown assignment operation");
+            }
+            storeVariable(variable, left);
+            x86_.mov(top, left);
+        }
+
+        void compileInstruction(std::uint32_t address)
+        {
+            const Instruction &instruction = code_[address];
+            std::uint32_t depth = getRelativeDepth(address);
+            X86::Register next = STACK_REGISTERS[std::min(depth, STACK_REGISTERS_COUNT - 1)];
+            X86::Register top = STACK_REGISTERS[depth > 0 ? depth - 1 : 0];
+            X86::Register second = STACK_REGISTERS[depth > 1 ? depth - 2 : 0];
+            switch (instruction.op)
+            {
+            case Opcode::PUSH:
+                x86_.mov(next, static_cast<std::int32_t>(instruction.arg));
+                return;
+            case Opcode::LOAD:
+                loadVariable(next, getVariable(instruction.arg));
+                return;
+            case Opcode::POP:
+                return;
+            case Opcode::JUMP:
+            case Opcode::LOOP:
+                x86_.jmp(getLabel(instruction.arg));
+                return;
+            case Opcode::JUMP_IF_FALSE:
+                x86_.test(top, top);
+                x86_.jcc(X86::EQUAL, getLabel(instruction.arg));
+                return;
+            case Opcode::CALL_UNARY:
+            case Opcode::CALL_BINARY:
+            case Opcode::ASSIGN:
+            case Opcode::POW:
+                emitCallBack(address);
+                return;
+            case Opcode::NOT:
+                x86_.test(top, top);
+                x86_.setAl(X86::EQUAL);
+                x86_.movzxAl(top);
+                return;
+            case Opcode::MUL:
+                x86_.imul(second, top);
+                return;
+            case Opcode::DIV:
+                compileDivision(address, second, top, false);
+                return;
+            case Opcode::MOD:
+                compileDivision(address, second, top, true);
+                return;
+            case Opcode::ADD:
+                x86_.add(second, top);
+                return;
+            case Opcode::SUB:
+                x86_.sub(second, top);
+                return;
+            case Opcode::EQUAL:
+                compileComparison(second, top, X86::EQUAL);
+                return;
+            case Opcode::NOT_EQUAL:
+                compileComparison(second, top, X86::NOT_EQUAL);
+                return;
+            case Opcode::GREATER:
+                compileComparison(second, top, X86::GREATER);
+                return;
+            case Opcode::GREATER_EQUAL:
+                compileComparison(second, top, X86::GREATER_EQUAL);
+                return;
+            case Opcode::LESS:
+                compileComparison(second, top, X86::LESS);
+                return;
+            case Opcode::LESS_EQUAL:
+                compileComparison(second, top, X86::LESS_EQUAL);
+                return;
+            case Opcode::OR:
+                x86_.mov(X86::RAX, second);
+                x86_.bitOr(X86::RAX, top);
+                x86_.setAl(X86::NOT_EQUAL);
+                x86_.movzxAl(second);
+                return;
+            case Opcode::AND:
+                x86_.test(second, second);
+                x86_.setAl(X86::NOT_EQUAL);
+                x86_.test(top, top);
+                x86_.setCl(X86::NOT_EQUAL);
+                x86_.andAlCl();
+                x86_.movzxAl(second);
+                return;
+            default:
+                compileAssignment(address, getVariable(instruction.arg), top);
+                return;
+            }
+        }
+
+        const BytecodeProgram &program_;
+        const std::vector<Instruction> &code_;
+        LoopInfo loop_;
+        std::uint32_t base_;                           // depth of stack, which is the first stack register
+        std::vector<token::symbol_t> variables_;       // variables in order of frame
+        X86 x86_;
+        std::vector<X86::Label> labels_;               // label of each address of loop and its end
+        std::vector<Deoptimization> deoptimizations_;  // returns before divisions
+        X86::Label exceptionLabel_ = 0;                // return after exception of called back operator
+    };
+#endif
+
+    // Compiles loop to code of cache, loop is marked as failed, if it can not be compiled
+    void compile(const BytecodeProgram &program, std::uint32_t loop, CompiledLoop &compiled)
+    {
+        compiled.failed = true;
+#ifdef PEACH_JIT_SUPPORTED
+        LoopCompiler compiler(program, program.getLoops()[loop]);
+        if (!compiler.check())
+        {
+            return;
+        }
+        try
+        {
+            compiled.code = reinterpret_cast<NativeLoop>(cache_.add(compiler.compile()));
+        }
+        catch (const std::runtime_error &)
+        {
+            return; // memory is not executable, loop is run by virtual machine
+        }
+        compiled.variables = compiler.getVariables();
+        compiled.failed = false;
+#else
+        (void)program;
+        (void)loop;
+#endif
+    }
+
+    std::uint32_t threshold_;                 // iterations of loop before its compilation
+    std::vector<ProgramLoops> programs_;      // loops of recently run programs, the last run one is the last
+    std::vector<VType *> values_;             // variables of scope of running loop
+    std::vector<VType> frame_;                // variables of running loop
+    tools::CodeCache cache_;
+};
+} // namespace expression
+} // namespace peach
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Exception.hpp"
+#include "Expression.hpp"
+
+namespace peach
+{
+namespace expression
+{
+// Operators with known semantics, arena evaluates their calls inline instead of calling operator function
+// Unary and binary operators go first, assignment operators follow them
+enum class BuiltinOperator : std::uint8_t
+{
+    NOT,
+    POW,
+    MUL,
+    DIV,
+    MOD,
+    ADD,
+    SUB,
+    EQUAL,
+    NOT_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    OR,
+    AND,
+    ASSIGN,
+    ADD_ASSIGN,
+    SUB_ASSIGN,
+    MUL_ASSIGN,
+    DIV_ASSIGN,
+    MOD_ASSIGN,
+    AND_ASSIGN,
+    OR_ASSIGN,
+    NONE,
+};
+
+// Returns number of operands of builtin operator, it is 0 for assignment operators and NONE
+constexpr std::size_t getArity(BuiltinOperator op) noexcept
+{
+    return op == BuiltinOperator::NOT ? 1 : op < BuiltinOperator::ASSIGN ? 2 : 0;
+}
+
+// Functors of builtin operators
+// Operator of ARITY 1 or 2 returns result of its operands, assignment operator (ARITY 0) changes its left operand
+namespace operators
+{
+template <BuiltinOperator Id, std::size_t Arity>
+struct OperatorTraits
+{
+    static constexpr BuiltinOperator ID = Id;
+    static constexpr std::size_t ARITY = Arity;
+};
+
+struct Not : OperatorTraits<BuiltinOperator::NOT, 1>
+{
+    VType operator()(VType value) const { return !value; }
+};
+
+struct Pow : OperatorTraits<BuiltinOperator::POW, 2>
+{
+    VType operator()(VType x, VType deg) const
+    {
+        VType res = 1;
+        while (deg)
+        {
+            if (!(deg & 1))
+            {
+                x *= x;
+                deg >>= 1;
+            }
+            else
+            {
+                res *= x;
+                --deg;
+            }
+        }
+        return res;
+    }
+};
+
+struct Mul : OperatorTraits<BuiltinOperator::MUL, 2>
+{
+    VType operator()(VType left, VType right) const { return left * right; }
+};
+
+struct Div : OperatorTraits<BuiltinOperator::DIV, 2>
+{
+    VType operator()(VType left, VType right) const
+    {
+        if (right == 0)
+        {
+            throw exception::ZeroDivisionError();
+        }
+        return left / right;
+    }
+};
+
+struct Mod : OperatorTraits<BuiltinOperator::MOD, 2>
+{
+    VType operator()(VType left, VType right) const { return left % right; }
+};
+
+struct Add : OperatorTraits<BuiltinOperator::ADD, 2>
+{
+    VType operator()(VType left, VType right) const { return left + right; }
+};
+
+struct Sub : OperatorTraits<BuiltinOperator::SUB, 2>
+{
+    VType operator()(VType left, VType right) const { return left - right; }
+};
+
+struct Equal : OperatorTraits<BuiltinOperator::EQUAL, 2>
+{
+    VType operator()(VType left, VType right) const { return left == right; }
+};
+
+struct NotEqual : OperatorTraits<BuiltinOperator::NOT_EQUAL, 2>
+{
+    VType operator()(VType left, VType right) const { return left != right; }
+};
+
+struct Greater : OperatorTraits<BuiltinOperator::GREATER, 2>
+{
+    VType operator()(VType left, VType right) const { return left > right; }
+};
+
+struct GreaterEqual : OperatorTraits<BuiltinOperator::GREATER_EQUAL, 2>
+{
+    VType operator()(VType left, VType right) const { return left >= right; }
+};
+
+struct Less : OperatorTraits<BuiltinOperator::LESS, 2>
+{
+    VType operator()(VType left, VType right) const { return left < right; }
+};
+
+struct LessEqual : OperatorTraits<BuiltinOperator::LESS_EQUAL, 2>
+{
+    VType operator()(VType left, VType right) const { return left <= right; }
+};
+
+// Both operands are evaluated, like operands of any other call
+struct Or : OperatorTraits<BuiltinOperator::OR, 2>
+{
+    VType operator()(VType left, VType right) const { return left || right; }
+};
+
+struct And : OperatorTraits<BuiltinOperator::AND, 2>
+{
+    VType operator()(VType left, VType right) const { return left && right; }
+};
+
+struct Assign : OperatorTraits<BuiltinOperator::ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left = right; }
+};
+
+struct AddAssign : OperatorTraits<BuiltinOperator::ADD_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left += right; }
+};
+
+struct SubAssign : OperatorTraits<BuiltinOperator::SUB_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left -= right; }
+};
+
+struct MulAssign : OperatorTraits<BuiltinOperator::MUL_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left *= right; }
+};
+
+struct DivAssign : OperatorTraits<BuiltinOperator::DIV_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left /= right; }
+};
+
+struct ModAssign : OperatorTraits<BuiltinOperator::MOD_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left %= right; }
+};
+
+struct AndAssign : OperatorTraits<BuiltinOperator::AND_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left &= right; }
+};
+
+struct OrAssign : OperatorTraits<BuiltinOperator::OR_ASSIGN, 0>
+{
+    void operator()(VType &left, VType right) const { left |= right; }
+};
+} // namespace operators
+} // namespace expression
+} // namespace peach
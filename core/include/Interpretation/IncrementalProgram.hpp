@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Exception.hpp"
+#include "Expression.hpp"
+#include "Interpreter.hpp"
+#include "Lexer.hpp"
+
+namespace peach
+{
+namespace interpreter
+{
+// Program, which stays interpreted while its lines are edited
+// Program is split into top level blocks: line without indentation (except 'else' one) with all following lines,
+// which are indented, blank or 'else' ones. Interpretation of block does not depend on other blocks,
+// because interpreter closes all indentation levels before such line. So an edit re-lexes and re-interpretates
+// only blocks, which contain edited lines, and splices their expressions into sequence of the whole program.
+// Every block is built in its own expression arena, so arenas of replaced blocks are freed at once.
+// Result is always the same, as interpretation of the whole text.
+// Tokens of lexer must not span several lines.
+class IncrementalProgram
+{
+public:
+    IncrementalProgram(std::shared_ptr<const fsm::Lexer> lexer, Interpreter interpreter)
+        : lexer_(std::move(lexer)),
+          interpreter_(std::move(interpreter)),
+          program_(std::make_shared<expression::ExpressionSequence>())
+    {
+        if (!lexer_)
+        {
+            throw std::invalid_argument("nullptr lexer in IncrementalProgram constructor");
+        }
+    }
+
+    // Replaces text of program
+    void setText(std::string_view text)
+    {
+        edit(0, lines_.size(), text);
+    }
+
+    // Replaces lines [firstLine, lastLine) with lines of text
+    // Every line of text ends with '\n', the last one may omit it. Empty text erases lines.
+    // Work is proportional to size of top level blocks, which contain edited lines
+    void edit(std::size_t firstLine, std::size_t lastLine, std::string_view text)
+    {
+        if (firstLine > lastLine || lastLine > lines_.size())
+        {
+            throw std::out_of_range("edited lines are out of program");
+        }
+
+        // Blocks [firstBlock, endBlock) are rebuilt, new lines may continue block before the first edited line
+        std::size_t firstBlock = 0, endBlock = 0;
+        if (!blocks_.empty())
+        {
+            firstBlock = findBlock(firstLine);
+            if (firstBlock > 0 && blocks_[firstBlock].firstLine == firstLine)
+            {
+                --firstBlock;
+            }
+            endBlock = (lastLine > firstLine ? std::max(findBlock(lastLine - 1), firstBlock) : firstBlock) + 1;
+        }
+        std::size_t regionBegin = firstBlock < endBlock ? blocks_[firstBlock].firstLine : 0;
+        std::size_t regionEnd = firstBlock < endBlock ? getEndLine(blocks_[endBlock - 1]) : 0;
+        std::size_t firstExpression = firstBlock < endBlock ? blocks_[firstBlock].firstExpression : 0;
+        std::size_t expressionsEnd = firstBlock < endBlock ? getEndExpression(blocks_[endBlock - 1]) : 0;
+
+        std::vector<std::string> newLines = splitLines(text);
+        lines_.erase(lines_.begin() + firstLine, lines_.begin() + lastLine);
+        lines_.insert(lines_.begin() + firstLine, std::make_move_iterator(newLines.begin()), std::make_move_iterator(newLines.end()));
+        regionEnd = regionEnd + newLines.size() - (lastLine - firstLine);
+
+        std::vector<Block> newBlocks;
+        std::vector<expression::ExprShPtr> expressions;
+        interpretateRegion(regionBegin, regionEnd, newBlocks, expressions);
+        for (auto &block : newBlocks)
+        {
+            block.firstExpression += firstExpression;
+        }
+        program_->replaceExpressions(firstExpression, expressionsEnd - firstExpression, std::move(expressions));
+
+        // Blocks after region are not changed, but they are moved, their errors are relative to them
+        std::ptrdiff_t linesShift = static_cast<std::ptrdiff_t>(regionEnd) -
+                                    static_cast<std::ptrdiff_t>(firstBlock < endBlock ? getEndLine(blocks_[endBlock - 1]) : 0);
+        std::ptrdiff_t expressionsShift = static_cast<std::ptrdiff_t>(newBlocks.empty() ? firstExpression : getEndExpression(newBlocks.back())) -
+                                          static_cast<std::ptrdiff_t>(expressionsEnd);
+        blocks_.erase(blocks_.begin() + firstBlock, blocks_.begin() + endBlock);
+        blocks_.insert(blocks_.begin() + firstBlock, newBlocks.begin(), newBlocks.end());
+        for (std::size_t id = firstBlock + newBlocks.size(); id < blocks_.size(); ++id)
+        {
+            blocks_[id].firstLine = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(blocks_[id].firstLine) + linesShift);
+            blocks_[id].firstExpression = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(blocks_[id].firstExpression) + expressionsShift);
+        }
+    }
+
+    // Returns sequence of expressions of the whole program
+    // Throws the first interpretation error of program, like interpretation of the whole text does
+    expression::ExprShPtr getProgram() const
+    {
+        for (const auto &block : blocks_)
+        {
+            if (block.diagnostic)
+            {
+                auto diagnostic = *block.diagnostic;
+                diagnostic.line += static_cast<std::uint32_t>(block.firstLine);
+                exception::throwDiagnostic(diagnostic);
+            }
+            if (block.error)
+            {
+                std::rethrow_exception(block.error);
+            }
+        }
+        return program_;
+    }
+
+    // Returns text of program, every line ends with '\n'
+    std::string getText() const
+    {
+        return joinLines(0, lines_.size());
+    }
+
+    std::size_t getLineCount() const noexcept
+    {
+        return lines_.size();
+    }
+
+private:
+    // Top level block of program
+    struct Block
+    {
+        std::size_t firstLine = 0;
+        std::size_t lineCount = 0;
+        std::size_t firstExpression = 0; // index of the first expression of block in program sequence
+        std::size_t expressionCount = 0;
+        std::optional<exception::Diagnostic> diagnostic; // positional error, its line is relative to block, so moves need not update it
+        std::exception_ptr error;                        // other interpretation error, block has no expressions, if it has any error
+    };
+
+    static std::size_t getEndLine(const Block &block) noexcept
+    {
+        return block.firstLine + block.lineCount;
+    }
+
+    static std::size_t getEndExpression(const Block &block) noexcept
+    {
+        return block.firstExpression + block.expressionCount;
+    }
+
+    // Returns index of block, which contains line, the last block for line after program
+    std::size_t findBlock(std::size_t line) const
+    {
+        auto it = std::upper_bound(blocks_.begin(), blocks_.end(), line, [](std::size_t line, const Block &block) {
+            return line < block.firstLine;
+        });
+        return it - blocks_.begin() - 1;
+    }
+
+    // Lexes and interpretates lines [begin, end), they must begin with top level block
+    // Appends blocks of lines and their expressions, block expression indices are relative to region
+    void interpretateRegion(std::size_t begin, std::size_t end, std::vector<Block> &blocks, std::vector<expression::ExprShPtr> &expressions)
+    {
+        if (begin == end)
+        {
+            return;
+        }
+        std::string text = joinLines(begin, end);
+        auto tokens = lexer_->tokenize(text, interpreter_.getSymbolTable().get());
+        tokens.setFirstLine(begin);
+
+        // Top level lines split tokens into blocks
+        struct BlockTokens
+        {
+            TokenIterator begin;
+            std::size_t depth; // depth of line before block
+        };
+        std::vector<BlockTokens> starts = {{tokens.begin(), 0}};
+        std::vector<std::size_t> firstLines = {begin};
+        std::size_t depth = 0;
+        std::size_t line = begin;
+        for (auto it = tokens.begin(); it < tokens.end(); ++line)
+        {
+            auto lineBegin = it;
+            std::size_t depthBefore = depth;
+            bool broken = false;
+            for (; it < tokens.end() && isIndentationBlockToken(*it); ++it)
+                ;
+            for (; it < tokens.end() && token::isIndentation(*it); ++it)
+            {
+                if (it->getCategory() == token::tokenCategory::INDENT)
+                {
+                    ++depth;
+                }
+                else if (it->getCategory() == token::tokenCategory::DEDENT && depth > 0)
+                {
+                    --depth;
+                }
+                else
+                {
+                    broken = true;
+                }
+            }
+            bool hasCode = it < tokens.end() && !token::isEndline(*it);
+            if (line != begin && hasCode && !broken && depth == 0 && it->getCategory() != token::tokenCategory::COND_ELSE)
+            {
+                starts.push_back({lineBegin, depthBefore});
+                firstLines.push_back(line);
+            }
+            for (; it < tokens.end() && !token::isEndline(*it); ++it)
+                ;
+            if (it < tokens.end())
+            {
+                ++it;
+            }
+        }
+        starts.push_back({tokens.end(), 0});
+        firstLines.push_back(end);
+
+        for (std::size_t id = 0; id + 1 < starts.size(); ++id)
+        {
+            Block block;
+            block.firstLine = firstLines[id];
+            block.lineCount = firstLines[id + 1] - firstLines[id];
+            block.firstExpression = expressions.size();
+            try
+            {
+                interpreter_.reset();
+                interpreter_.interpretateLines(starts[id].begin, starts[id + 1].begin, starts[id].depth);
+                expressions.push_back(interpreter_.getInterpretationResult());
+                block.expressionCount = 1;
+            }
+            catch (const exception::PositionalError &error)
+            {
+                expressions.resize(block.firstExpression);
+                block.diagnostic = exception::Diagnostic{static_cast<std::uint32_t>(error.getLine() - block.firstLine),
+                                                         static_cast<std::uint32_t>(error.getPosition()),
+                                                         error.getCode()};
+            }
+            catch (...)
+            {
+                expressions.resize(block.firstExpression);
+                block.error = std::current_exception();
+            }
+            blocks.push_back(std::move(block));
+        }
+        interpreter_.reset();
+    }
+
+    bool isIndentationBlockToken(const token::Token &tk) const
+    {
+        const auto &block = lexer_->getIndentationBlock();
+        return std::find(block.begin(), block.end(), tk.getCategory()) != block.end();
+    }
+
+    // Returns lines [begin, end), every one ends with '\n'
+    std::string joinLines(std::size_t begin, std::size_t end) const
+    {
+        std::string text;
+        for (std::size_t line = begin; line < end; ++line)
+        {
+            text += lines_[line];
+            text += '\n';
+        }
+        return text;
+    }
+
+    static std::vector<std::string> splitLines(std::string_view text)
+    {
+        std::vector<std::string> lines;
+        for (std::size_t begin = 0; begin < text.size();)
+        {
+            std::size_t end = std::min(text.find('\n', begin), text.size());
+            lines.emplace_back(text.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return lines;
+    }
+
+    std::shared_ptr<const fsm::Lexer> lexer_;                   // lexer with indentation tracking
+    Interpreter interpreter_;                                   // interpreter of blocks
+    std::vector<std::string> lines_;                            // lines of program without '\n'
+    std::vector<Block> blocks_;                                 // top level blocks, they cover all lines in order
+    std::shared_ptr<expression::ExpressionSequence> program_;   // expressions of all blocks in order
+};
+} // namespace interpreter
+} // namespace peach
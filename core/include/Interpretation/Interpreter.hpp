@@ -1,45 +1,104 @@
 #pragma once
 
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <limits>
+#include <optional>
 #include <stack>
+#include <string_view>
 #include <variant>
 
+#include "Diagnostic.hpp"
 #include "Exception.hpp"
 #include "Expression.hpp"
-#include "Indentator.hpp"
-#include "Token.hpp"
+#include "ExpressionArena.hpp"
+#include "SymbolTable.hpp"
+#include "ThreadPool.hpp"
+#include "TokenBuffer.hpp"
+#include "TokenStream.hpp"
 
 namespace peach
 {
 namespace interpreter
 {
+using TokenIterator = token::TokenBuffer::const_iterator;
+
 // Contains information about FunctionCall, such as binary or unary operator
+// Calls of builtin operator are evaluated without functor, calls of other operators use functor
 struct OperatorInfo
 {
-    expression::FunctionCall::FunctionType functor;
+    expression::CallFunction functor;
     std::string tokenString;
     token::tokenCategory_t tokenCategory;
+    expression::BuiltinOperator builtin = expression::BuiltinOperator::NONE;
 };
 
 // Contains information about AssignExpression, such as simple assignation '=' or '+='
 struct AssignOperatorInfo
 {
-    expression::AssignExpression::FunctionType functor;
+    expression::AssignFunction functor;
     std::string tokenString;
     token::tokenCategory_t tokenCategory;
+    expression::BuiltinOperator builtin = expression::BuiltinOperator::NONE;
 };
 
+// Returns information about builtin unary or binary operator of expression::operators
+template <typename OperatorT>
+OperatorInfo makeOperatorInfo(std::string tokenString, token::tokenCategory_t tokenCategory)
+{
+    static_assert(OperatorT::ARITY == 1 || OperatorT::ARITY == 2, "operator must be unary or binary");
+    expression::CallFunction functor = [](expression::PeachTuple args) {
+        if constexpr (OperatorT::ARITY == 1)
+        {
+            return OperatorT()(args[0]);
+        }
+        else
+        {
+            return OperatorT()(args[0], args[1]);
+        }
+    };
+    return {std::move(functor), std::move(tokenString), tokenCategory, OperatorT::ID};
+}
+
+// Returns information about builtin assignment operator of expression::operators
+template <typename AssignT>
+AssignOperatorInfo makeAssignOperatorInfo(std::string tokenString, token::tokenCategory_t tokenCategory)
+{
+    static_assert(AssignT::ARITY == 0, "operator must be assignment");
+    return {AssignT(), std::move(tokenString), tokenCategory, AssignT::ID};
+}
+
 // Interpretates tokens into evaluable Exresstions
+// Expressions are built as nodes of single arena, it is replaced on reset, so built expressions keep the old one
 class Interpreter
 {
 private:
+    // Indentation level, which is not closed yet
+    // Conditional or loop is added to arena, when its level is closed, after all its nodes
     struct UnfinishedExpression
     {
-        expression::ExprShPtr expression;
-        std::shared_ptr<expression::ExpressionSequence> sequence;
         token::tokenCategory_t type;
+        expression::node_t condition = expression::ExpressionArena::NO_NODE;
+        expression::node_t ifWay = expression::ExpressionArena::NO_NODE; // closed if way of conditional with else
+        std::vector<expression::node_t> sequence;                       // expressions of level
+    };
+
+    // Operator of expressions, operator with greater priority binds first
+    // Its functions are found in operator functions table by its index in operators
+    struct Operator
+    {
+        std::string string;
+        int priority = 0;
     };
 
+    static constexpr std::uint16_t NO_ENTRY = std::numeric_limits<std::uint16_t>::max();
+    static constexpr std::size_t MAX_EXPRESSION_DEPTH = 4096; // recursion limit of expression parser
+
 public:
+    static constexpr std::size_t MIN_CHUNK_TOKENS = 1 << 16;
+    static constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
     // SingleIndentationBlock defines one block of indentation
     // Operators order is important, it used in expression building
     // Constructor resets interpreter state
@@ -49,19 +108,57 @@ public:
         : singleIndentationBlock_(std::move(singleIndentationBlock))
     {
         reset();
-        std::size_t curPrior = assignOperatorsOrder.size() + 1 + operatorsOrder.size();
+        int curPrior = static_cast<int>(assignOperatorsOrder.size() + operatorsOrder.size());
         for (const auto &op : operatorsOrder)
         {
-            operatorPriority_[op.tokenString] = curPrior--;
-            operatorFunction_[op.tokenString] = op.functor;
+            std::size_t id = addOperator(op.tokenString);
+            operators_[id].priority = curPrior--;
+            functions_->calls[id] = op.functor;
+            functions_->callBuiltins[id] = op.builtin;
         }
         for (const auto &op : assignOperatorsOrder)
         {
-            operatorPriority_[op.tokenString] = curPrior--;
-            assignOperatorFunction_[op.tokenString] = op.functor;
+            std::size_t id = addOperator(op.tokenString);
+            operators_[id].priority = curPrior--;
+            functions_->assignments[id] = op.functor;
+            functions_->assignmentBuiltins[id] = op.builtin;
         }
     }
 
+    // Sets table, which names of variables are interned into
+    // It must be the table, tokens were interned into by lexer, if they were
+    void setSymbolTable(std::shared_ptr<token::SymbolTable> symbols)
+    {
+        symbols_ = std::move(symbols);
+    }
+
+    const std::shared_ptr<token::SymbolTable> &getSymbolTable() const noexcept
+    {
+        return symbols_;
+    }
+
+    // Connects interpreter to lexer, which gives operator id i to the i-th pattern of (pattern, category) pairs
+    // Operators of tokens are found by their ids then, so tokens must come from that lexer
+    // Pattern, which is not operator of interpreter, stays undefined operator
+    template <typename Patterns>
+    void setOperatorPatterns(const Patterns &patterns)
+    {
+        operatorOfId_.clear();
+        for (const auto &pattern : patterns)
+        {
+            auto op = std::find_if(operators_.begin(), operators_.end(), [&](const Operator &candidate) {
+                return candidate.string == pattern.first;
+            });
+            operatorOfId_.push_back(op == operators_.end() ? NO_ENTRY : static_cast<std::uint16_t>(op - operators_.begin()));
+        }
+    }
+
+    // Returns tokens of single indentation level, lexer must emit indentation tokens for it
+    const std::vector<token::tokenCategory_t> &getSingleIndentationBlock() const noexcept
+    {
+        return singleIndentationBlock_;
+    }
+
     // Returns current indentation level
     std::size_t getIndentationLevel() const noexcept
     {
@@ -71,161 +168,565 @@ public:
     // Interpretates single line as Expression
     // Puts constructed expression to the corresponding place
     // Space tokens from begin to end sould not contain SEP_ENDL tokens
+    // Line must be the first one of its text, so indentation tokens of lexer count its depth from 0
     void interpretateLine(TokenIterator beginTokens,
                           TokenIterator endTokens)
     {
-        for (auto it = beginTokens; it < endTokens; ++it)
+        std::size_t lexerDepth = 0;
+        interpretateLine(beginTokens, endTokens, lexerDepth);
+    }
+
+    // Interpreatates all given tokens to Expressions
+    // lexerDepth is depth of line before tokens, if they do not begin text
+    void interpretateLines(TokenIterator tokensBegin, TokenIterator tokensEnd, std::size_t lexerDepth = 0)
+    {
+        while (tokensBegin < tokensEnd)
         {
-            if (!(*it))
+            auto curEnd = getNextEndlineTokenIt(tokensBegin, tokensEnd);
+            interpretateLine(tokensBegin, curEnd, lexerDepth);
+            tokensBegin = curEnd + 1;
+        }
+    }
+
+    // Interpretates tokens like interpretateLines, but does not throw positional errors
+    // The first error of every broken line is appended to diagnostics, and interpretation recovers at the next line,
+    // so single pass reports errors of all lines. Built expressions must not be evaluated, if any error is reported.
+    void interpretateLines(TokenIterator tokensBegin,
+                           TokenIterator tokensEnd,
+                           std::vector<exception::Diagnostic> &diagnostics,
+                           std::size_t lexerDepth = 0)
+    {
+        while (tokensBegin < tokensEnd)
+        {
+            auto curEnd = getNextEndlineTokenIt(tokensBegin, tokensEnd);
+            if (!tryInterpretateLine(tokensBegin, curEnd, lexerDepth, true))
             {
-                throw std::invalid_argument("can not interpretate nullptr token");
+                diagnostics.push_back(*error_);
             }
-            if (token::isEndline(*it))
+            tokensBegin = curEnd + 1;
+        }
+    }
+
+    // Interpretates lines, pulled from stream, until it is over
+    // Only tokens of one line are alive, lines are checked for undefined tokens by lexer
+    // Lexer of stream must emit indentation tokens with the same singleIndentationBlock
+    void interpretateLines(fsm::TokenStream &stream)
+    {
+        std::size_t lexerDepth = 0;
+        while (stream.nextLine())
+        {
+            if (!interpretateStreamLine(stream, lexerDepth, false))
             {
-                throw std::invalid_argument("line can not contain endline token");
+                exception::throwDiagnostic(*error_);
             }
-            if ((*it)->getCategory() == token::tokenCategory::UNDEFINED)
+        }
+    }
+
+    // Interpretates lines, pulled from stream, and reports their errors like interpretateLines with diagnostics
+    void interpretateLines(fsm::TokenStream &stream, std::vector<exception::Diagnostic> &diagnostics)
+    {
+        std::size_t lexerDepth = 0;
+        while (stream.nextLine())
+        {
+            if (!interpretateStreamLine(stream, lexerDepth, true))
             {
-                exception::throwFromTokenIterator<exception::UndefinedTokenError>(it);
+                diagnostics.push_back(*error_);
             }
         }
-        if (unfinishedExpressions_.empty())
+    }
+
+    // Interpretates tokens like interpretateLines, but expressions of lines are built by pool workers
+    // Tokens are split after line ends into chunks of at least minChunkTokens tokens. Every worker builds
+    // expressions of its chunk lines in its own arena, they do not depend on indentation. Then chunks are stitched
+    // sequentially: their arenas are appended to interpreter one, indentation levels are applied to their lines.
+    // Errors of lines are thrown in the same order as interpretateLines does, so positional errors are the same.
+    // Names without symbol are interned before workers start, in order of tokens.
+    void interpretateLines(TokenIterator tokensBegin,
+                           TokenIterator tokensEnd,
+                           tools::ThreadPool &pool,
+                           std::size_t lexerDepth = 0,
+                           std::size_t minChunkTokens = MIN_CHUNK_TOKENS)
+    {
+        for (auto it = tokensBegin; it < tokensEnd; ++it)
         {
-            throw std::logic_error("unfinished expressions stack is empty");
+            if (it->getCategory() == token::tokenCategory::NAME && it->getSymbol() == token::SymbolTable::NO_SYMBOL)
+            {
+                symbols_->intern(it->getTokenString());
+            }
+        }
+        std::size_t chunkTokens = std::max<std::size_t>(minChunkTokens, (tokensEnd - tokensBegin) / (pool.size() * CHUNKS_PER_THREAD) + 1);
+        std::vector<std::future<Chunk>> chunks;
+        while (tokensBegin < tokensEnd)
+        {
+            auto chunkEnd = tokensEnd - tokensBegin > static_cast<std::ptrdiff_t>(chunkTokens)
+                                ? std::min(getNextEndlineTokenIt(tokensBegin + chunkTokens, tokensEnd) + 1, tokensEnd)
+                                : tokensEnd;
+            chunks.push_back(pool.submit([worker = Interpreter(*this, WorkerTag{}), tokensBegin, chunkEnd]() mutable {
+                return worker.buildChunk(tokensBegin, chunkEnd);
+            }));
+            tokensBegin = chunkEnd;
+        }
+        try
+        {
+            for (auto &chunk : chunks)
+            {
+                stitchChunk(chunk.get(), lexerDepth);
+            }
+        }
+        catch (...)
+        {
+            // Workers refer to tokens, they must finish before leaving
+            for (auto &chunk : chunks)
+            {
+                if (chunk.valid())
+                {
+                    chunk.wait();
+                }
+            }
+            throw;
         }
-        auto [lineIndentationLevel, firstNotIndentationIt] = Indentator::getIndentation(beginTokens,
-                                                                                        endTokens,
-                                                                                        singleIndentationBlock_);
-        beginTokens = firstNotIndentationIt;
+    }
+
+    // Returns sequence of expressions built after interpretator construction or Interpreter::reset() call
+    // Sequence refers to arena of interpreter, so it stays valid after reset
+    expression::ExprShPtr getInterpretationResult()
+    {
+        while (getIndentationLevel() > 0)
+        {
+            popIndentation();
+        }
+        return std::make_shared<expression::ArenaExpression>(arena_, arena_->addSequence(unfinishedExpressions_.top().sequence));
+    }
+
+    // Resets all built expressions, next ones are built in new arena
+    void reset()
+    {
+        while (!unfinishedExpressions_.empty())
+        {
+            unfinishedExpressions_.pop();
+        }
+        arena_ = std::make_shared<expression::ExpressionArena>(functions_);
+        pushNewIndentation(token::tokenCategory::UNDEFINED);
+    }
+
+private:
+    struct WorkerTag
+    {
+    };
+
+    // Interpreter, which builds lines of chunk for other one
+    // It shares tables of other interpreter, but only reads its symbol table
+    Interpreter(const Interpreter &other, WorkerTag)
+        : singleIndentationBlock_(other.singleIndentationBlock_),
+          operators_(other.operators_),
+          operatorOfId_(other.operatorOfId_),
+          functions_(other.functions_),
+          internNames_(false),
+          symbols_(other.symbols_)
+    {
+        reset();
+    }
+
+    // Expressions of line: condition of 'if' or 'while', declaration and definition, or single expression
+    struct LineNodes
+    {
+        expression::node_t first = expression::ExpressionArena::NO_NODE;
+        expression::node_t second = expression::ExpressionArena::NO_NODE;
+    };
+
+    // Line, which expressions are built by pool worker
+    struct LineExpression
+    {
+        TokenIterator begin;
+        TokenIterator end;
+        LineNodes nodes;                            // nodes in arena of chunk
+        std::optional<exception::Diagnostic> error; // positional error of line
+        std::exception_ptr exception;               // other error of line building
+        bool checked = true;                        // if tokens of line are valid, error is thrown before indentation is applied otherwise
+    };
+
+    // Lines of tokens chunk with their expressions
+    struct Chunk
+    {
+        std::shared_ptr<const expression::ExpressionArena> arena;
+        std::vector<LineExpression> lines;
+    };
+
+    // Interpretates single line, lexerDepth is depth of previous line of text, line updates it
+    // Depth is changed by INDENT and DEDENT tokens, which lexer emits with the same singleIndentationBlock
+    // Broken line is not recovered: levels it closes stay closed, but it opens none, like line was not written
+    void interpretateLine(TokenIterator beginTokens,
+                          TokenIterator endTokens,
+                          std::size_t &lexerDepth)
+    {
+        if (!tryInterpretateLine(beginTokens, endTokens, lexerDepth, false))
+        {
+            exception::throwDiagnostic(*error_);
+        }
+    }
+
+    // Interpretates single line like interpretateLine, but keeps its positional error instead of throwing it
+    // Returns false, if line is broken, error_ is its first error then
+    bool tryInterpretateLine(TokenIterator beginTokens,
+                             TokenIterator endTokens,
+                             std::size_t &lexerDepth,
+                             bool recover)
+    {
+        error_.reset();
+        checkLineTokens(beginTokens, endTokens);
+        return interpretateCheckedLine(beginTokens, endTokens, lexerDepth, recover);
+    }
+
+    // Interpretates current line of stream like tryInterpretateLine, lexer has checked its tokens
+    bool interpretateStreamLine(const fsm::TokenStream &stream, std::size_t &lexerDepth, bool recover)
+    {
+        const auto &tokens = stream.getTokens();
+        error_.reset();
+        if (stream.getFirstUndefined() != fsm::TokenStream::NONE)
+        {
+            report(exception::ErrorCode::UNDEFINED_TOKEN, tokens.begin() + stream.getFirstUndefined());
+        }
+        return interpretateCheckedLine(tokens.begin(), tokens.end(), lexerDepth, recover);
+    }
+
+    // Interpretates single line, which tokens are checked already, error_ keeps their error
+    // If recover is set, indentation of broken line is still applied, and broken header opens its level
+    // with placeholder condition, so next lines are interpretated as if line had no error
+    bool interpretateCheckedLine(TokenIterator beginTokens,
+                                 TokenIterator endTokens,
+                                 std::size_t &lexerDepth,
+                                 bool recover)
+    {
+        beginTokens = skipIndentation(beginTokens, endTokens, lexerDepth);
         if (beginTokens == endTokens)
         {
-            return;
+            return !error_;
         }
         auto lineCategory = getLineCategory(beginTokens);
+        applyIndentation(beginTokens, lineCategory, lexerDepth, recover);
+        LineNodes nodes;
+        if (!error_)
+        {
+            nodes = buildLine(beginTokens, endTokens, lineCategory);
+        }
+        if (error_)
+        {
+            if (recover)
+            {
+                addBrokenLine(lineCategory);
+            }
+            return false;
+        }
+        addLine(lineCategory, nodes);
+        return true;
+    }
+
+    // Reports the first undefined token of line, throws, if line contains endline
+    void checkLineTokens(TokenIterator beginTokens, TokenIterator endTokens)
+    {
+        for (auto it = beginTokens; it < endTokens; ++it)
+        {
+            if (token::isEndline(*it))
+            {
+                throw std::invalid_argument("line can not contain endline token");
+            }
+            if (it->getCategory() == token::tokenCategory::UNDEFINED)
+            {
+                report(exception::ErrorCode::UNDEFINED_TOKEN, it);
+                return;
+            }
+        }
+    }
+
+    // Remembers error at token, only the first error of line is kept
+    void report(exception::ErrorCode code, TokenIterator it)
+    {
+        report(exception::makeDiagnostic(code, it));
+    }
 
+    void report(const std::optional<exception::Diagnostic> &error)
+    {
+        if (!error_)
+        {
+            error_ = error;
+        }
+    }
+
+    // Closes indentation levels, which line of category does not continue, line begins with code at beginTokens
+    // Else line closes if way of its conditional
+    // Too deep line and else line without conditional are reported, if recover is set, placeholder levels are opened for them
+    void applyIndentation(TokenIterator beginTokens, token::tokenCategory_t lineCategory, std::size_t lexerDepth, bool recover)
+    {
+        if (unfinishedExpressions_.empty())
+        {
+            throw std::logic_error("unfinished expressions stack is empty");
+        }
+        std::size_t lineIndentationLevel = lexerDepth;
+        bool elseAttached = false;
         while (lineIndentationLevel < getIndentationLevel())
         {
             if (getIndentationLevel() - lineIndentationLevel == 1 &&
                 unfinishedExpressions_.top().type == token::tokenCategory::COND_IF &&
+                unfinishedExpressions_.top().ifWay == expression::ExpressionArena::NO_NODE &&
                 lineCategory == token::tokenCategory::COND_ELSE)
             {
-                unfinishedExpressions_.top().expression->addExpressionFromNextIndentationLevel(unfinishedExpressions_.top().sequence);
-                unfinishedExpressions_.top().sequence = std::make_shared<expression::ExpressionSequence>();
+                auto &conditional = unfinishedExpressions_.top();
+                conditional.ifWay = arena_->addSequence(conditional.sequence);
+                conditional.sequence.clear();
                 ++lineIndentationLevel;
+                elseAttached = true;
                 break;
             }
             popIndentation();
         }
 
-        if (lineIndentationLevel != getIndentationLevel())
+        if (lineIndentationLevel > getIndentationLevel())
+        {
+            report(exception::ErrorCode::INDENTATION, beginTokens);
+            while (recover && lineIndentationLevel > getIndentationLevel())
+            {
+                pushNewIndentation(token::tokenCategory::UNDEFINED);
+            }
+        }
+        if (lineCategory == token::tokenCategory::COND_ELSE && !elseAttached)
         {
-            exception::throwFromTokenIterator<exception::IndentationError>(beginTokens);
+            report(exception::ErrorCode::UNEXPECTED_ELSE, beginTokens);
+            if (recover)
+            {
+                pushNewIndentation(token::tokenCategory::UNDEFINED);
+            }
         }
+    }
+
+    // Builds expressions of line of category, which code begins at beginTokens
+    // Line does not depend on indentation levels, so lines are built independently
+    // Error of line is reported, its nodes are not complete then
+    LineNodes buildLine(TokenIterator beginTokens, TokenIterator endTokens, token::tokenCategory_t lineCategory)
+    {
         switch (lineCategory)
         {
         case token::tokenCategory::COND_IF:
-        {
-            auto newConditionalExpression = std::make_shared<expression::Conditional>(
-                buildExpression(
-                    getNextNonSepTokenIt(beginTokens + 1, endTokens), endTokens));
-            pushNewIndentation(newConditionalExpression, lineCategory);
-            break;
-        }
+        case token::tokenCategory::LOOP_WHILE:
+            return {buildExpression(getNextNonSepTokenIt(beginTokens + 1, endTokens), endTokens)};
 
         case token::tokenCategory::COND_ELSE:
+            return {};
+
+        case token::tokenCategory::DECLARATION:
         {
-            if (unfinishedExpressions_.top().type != token::tokenCategory::COND_IF)
+            auto nameIterator = getNextNonSepTokenIt(beginTokens + 1, endTokens);
+            if (nameIterator == endTokens)
             {
-                exception::throwFromTokenIterator<exception::UnexpectedElseError>(beginTokens);
+                report(exception::ErrorCode::INVALID_VARIABLE_DECLARATION, beginTokens);
+                return {};
             }
-            break;
+            if (nameIterator->getCategory() != token::tokenCategory::NAME)
+            {
+                report(exception::ErrorCode::INVALID_VARIABLE_DECLARATION, nameIterator);
+                return {};
+            }
+
+            expression::node_t declaration = arena_->addVariableDeclaration(getSymbol(*nameIterator));
+            expression::node_t definition = buildExpression(nameIterator, endTokens);
+            return {declaration, definition};
         }
 
-        case token::tokenCategory::LOOP_WHILE:
-        {
-            auto newLoopExpression = std::make_shared<expression::LoopWhile>(
-                buildExpression(
-                    getNextNonSepTokenIt(beginTokens + 1, endTokens), endTokens));
-            pushNewIndentation(newLoopExpression, lineCategory);
-            break;
+        default:
+            return {buildExpression(beginTokens, endTokens)};
         }
+    }
 
-        case token::tokenCategory::DECLARATION:
+    // Puts built expressions of line of category to the corresponding place
+    void addLine(token::tokenCategory_t lineCategory, LineNodes nodes)
+    {
+        switch (lineCategory)
         {
-            auto nameIterator = getNextNonSepTokenIt(beginTokens + 1, endTokens);
-            if (!(*nameIterator) || (*nameIterator)->getCategory() != token::tokenCategory::NAME)
-            {
-                exception::throwFromTokenIterator<exception::InvalidVariableDeclarationError>(nameIterator);
-            }
+        case token::tokenCategory::COND_IF:
+        case token::tokenCategory::LOOP_WHILE:
+            pushNewIndentation(lineCategory, nodes.first);
+            break;
 
-            expression::ExprShPtr declaration = std::make_shared<expression::VariableDeclaration>((*nameIterator)->getTokenString());
-            expression::ExprShPtr definition = buildExpression(nameIterator, endTokens);
-            unfinishedExpressions_.top().sequence->addExpression(std::move(declaration));
-            unfinishedExpressions_.top().sequence->addExpression(std::move(definition));
+        case token::tokenCategory::COND_ELSE:
             break;
-        }
 
         default:
-            unfinishedExpressions_.top().sequence->addExpression(buildExpression(beginTokens, endTokens));
+            unfinishedExpressions_.top().sequence.push_back(nodes.first);
+            if (nodes.second != expression::ExpressionArena::NO_NODE)
+            {
+                unfinishedExpressions_.top().sequence.push_back(nodes.second);
+            }
             break;
         }
     }
 
-    // Interpreatates all given tokens to Expressions
-    void interpretateLines(TokenIterator tokensBegin, TokenIterator tokensEnd)
+    // Opens level of broken header with placeholder condition, other broken lines are skipped
+    void addBrokenLine(token::tokenCategory_t lineCategory)
     {
-        while (tokensBegin < tokensEnd)
+        if (lineCategory == token::tokenCategory::COND_IF || lineCategory == token::tokenCategory::LOOP_WHILE)
         {
-            auto curEnd = getNextEndlineTokenIt(tokensBegin, tokensEnd);
-            interpretateLine(tokensBegin, curEnd);
-            tokensBegin = curEnd + 1;
+            pushNewIndentation(lineCategory, arena_->addValue(0));
         }
     }
 
-    // Returns sequence of expressions built after interpretator construction or Interpreter::reset() call
-    expression::ExprShPtr getInterpretationResult()
+    // Builds expressions of lines from tokens in arena of interpreter, it must be reset
+    // Errors of lines are kept, so they are thrown in order of lines
+    Chunk buildChunk(TokenIterator tokensBegin, TokenIterator tokensEnd)
     {
-        while (getIndentationLevel() > 0)
+        Chunk chunk{arena_, {}};
+        while (tokensBegin < tokensEnd)
         {
-            popIndentation();
+            LineExpression line;
+            line.begin = tokensBegin;
+            line.end = getNextEndlineTokenIt(tokensBegin, tokensEnd);
+            tokensBegin = line.end + 1;
+            error_.reset();
+            try
+            {
+                checkLineTokens(line.begin, line.end);
+            }
+            catch (...)
+            {
+                line.exception = std::current_exception();
+                line.checked = false;
+                chunk.lines.push_back(line);
+                continue;
+            }
+            if (error_)
+            {
+                line.error = error_;
+                line.checked = false;
+                chunk.lines.push_back(line);
+                continue;
+            }
+            auto codeBegin = line.begin;
+            for (; codeBegin < line.end && (isIndentationBlockToken(*codeBegin) || token::isIndentation(*codeBegin)); ++codeBegin)
+                ;
+            if (codeBegin != line.end)
+            {
+                try
+                {
+                    line.nodes = buildLine(codeBegin, line.end, getLineCategory(codeBegin));
+                    line.error = error_;
+                }
+                catch (...)
+                {
+                    line.exception = std::current_exception();
+                }
+            }
+            chunk.lines.push_back(line);
         }
-        return unfinishedExpressions_.top().sequence;
+        return chunk;
     }
 
-    // Resets all built expressions
-    void reset()
+    // Interpretates built lines of chunk, lexerDepth is depth of line before them
+    void stitchChunk(const Chunk &chunk, std::size_t &lexerDepth)
     {
-        while (!unfinishedExpressions_.empty())
+        expression::node_t offset = arena_->append(*chunk.arena);
+        auto relocate = [offset](expression::node_t node) {
+            return node == expression::ExpressionArena::NO_NODE ? node : node + offset;
+        };
+        for (const auto &line : chunk.lines)
         {
-            unfinishedExpressions_.pop();
+            if (line.exception && !line.checked)
+            {
+                std::rethrow_exception(line.exception);
+            }
+            error_ = line.checked ? std::nullopt : line.error;
+            auto beginTokens = skipIndentation(line.begin, line.end, lexerDepth);
+            if (beginTokens != line.end)
+            {
+                auto lineCategory = getLineCategory(beginTokens);
+                applyIndentation(beginTokens, lineCategory, lexerDepth, false);
+                if (!error_ && line.exception)
+                {
+                    std::rethrow_exception(line.exception);
+                }
+                report(line.error);
+                if (!error_)
+                {
+                    addLine(lineCategory, {relocate(line.nodes.first), relocate(line.nodes.second)});
+                }
+            }
+            if (error_)
+            {
+                exception::throwDiagnostic(*error_);
+            }
         }
-        pushNewIndentation(std::make_shared<expression::ExpressionSequence>(), token::tokenCategory::UNDEFINED);
     }
 
-private:
-    // Pops indentation level: closes latest expression sequence
+    // Pops indentation level: closes latest expression sequence and adds its conditional or loop
+    // Placeholder level of broken line is dropped with its lines, so they are never evaluated
     void popIndentation()
     {
-        auto expr = unfinishedExpressions_.top().expression;
-        expr->addExpressionFromNextIndentationLevel(unfinishedExpressions_.top().sequence);
+        auto level = std::move(unfinishedExpressions_.top());
         unfinishedExpressions_.pop();
-        unfinishedExpressions_.top().sequence->addExpression(expr);
+        if (level.type == token::tokenCategory::UNDEFINED)
+        {
+            return;
+        }
+        expression::node_t body = arena_->addSequence(level.sequence);
+        expression::node_t expr = expression::ExpressionArena::NO_NODE;
+        if (level.type == token::tokenCategory::LOOP_WHILE)
+        {
+            expr = arena_->addLoopWhile(level.condition, body);
+        }
+        else if (level.ifWay == expression::ExpressionArena::NO_NODE)
+        {
+            expr = arena_->addConditional(level.condition, body);
+        }
+        else
+        {
+            expr = arena_->addConditional(level.condition, level.ifWay, body);
+        }
+        unfinishedExpressions_.top().sequence.push_back(expr);
     }
 
-    // Pushes expr of type as new indentation level
-    void pushNewIndentation(expression::ExprShPtr expr, token::tokenCategory_t type)
+    // Pushes new indentation level of conditional or loop with condition
+    void pushNewIndentation(token::tokenCategory_t type, expression::node_t condition = expression::ExpressionArena::NO_NODE)
     {
         UnfinishedExpression newExpr;
-        newExpr.expression = std::move(expr);
-        newExpr.sequence = std::make_shared<expression::ExpressionSequence>();
         newExpr.type = type;
+        newExpr.condition = condition;
         unfinishedExpressions_.emplace(std::move(newExpr));
     }
 
+    // Returns the first token after indentation of line, applies indentation tokens of lexer to depth
+    // Reports IndentationError, if lexer has found broken indentation, the rest tokens are still applied
+    TokenIterator skipIndentation(TokenIterator begin, TokenIterator end, std::size_t &depth)
+    {
+        for (; begin < end && isIndentationBlockToken(*begin); ++begin)
+            ;
+        for (; begin < end && token::isIndentation(*begin); ++begin)
+        {
+            switch (begin->getCategory())
+            {
+            case token::tokenCategory::INDENT:
+                ++depth;
+                break;
+            case token::tokenCategory::DEDENT:
+                if (depth == 0)
+                {
+                    report(exception::ErrorCode::INDENTATION, begin);
+                    break;
+                }
+                --depth;
+                break;
+            default:
+                report(exception::ErrorCode::INDENTATION, begin);
+            }
+        }
+        return begin;
+    }
+
+    bool isIndentationBlockToken(const token::Token &tk) const
+    {
+        return std::find(singleIndentationBlock_.begin(), singleIndentationBlock_.end(), tk.getCategory()) != singleIndentationBlock_.end();
+    }
+
     // Returns line category of TokenIterator
     static token::tokenCategory_t getLineCategory(TokenIterator itBegin)
     {
-        return (*itBegin)->getCategory();
+        return itBegin->getCategory();
     }
 
     // Returns iterator on next non separation token
@@ -244,181 +745,297 @@ private:
         return begin;
     }
 
-    // Constructs expression from line
-    expression::ExprShPtr buildExpression(TokenIterator begin, TokenIterator end)
+    // Constructs expression from line, returns NO_NODE, if its error is reported
+    expression::node_t buildExpression(TokenIterator begin, TokenIterator end)
     {
-        struct OperatorInfo
-        {
-            std::string string;
-            token::tokenCategory_t category;
-            TokenIterator position;
-        };
         if (begin == end)
         {
-            return std::make_shared<expression::VTypeValue>(0);
+            return arena_->addValue(0);
         }
-        std::vector<OperatorInfo> operators;
-        std::vector<expression::ExprShPtr> expressions;
-        auto curIt = begin;
-
-        auto throwBadOperator = [&]() {
-            auto badIt = operators.empty() ? begin : operators.back().position;
-            exception::throwFromTokenIterator<exception::SyntaxError>(badIt);
-        };
+        if (!checkBrackets(begin, end))
+        {
+            return expression::ExpressionArena::NO_NODE;
+        }
+        auto it = begin;
+        auto expression = parseExpression(it, end, 0, begin, 0);
+        if (expression != expression::ExpressionArena::NO_NODE && it < end)
+        {
+            reportAfterExpression(it);
+            return expression::ExpressionArena::NO_NODE;
+        }
+        return expression;
+    }
 
-        auto popArOperator = [&](std::size_t arity) {
-            if (operators.empty() ||
-                expressions.size() < arity)
+    // Reports BracketDisbalanceError at the first unmatched closing bracket or at the last unmatched opening one
+    bool checkBrackets(TokenIterator begin, TokenIterator end)
+    {
+        std::size_t depth = 0;
+        for (auto it = begin; it < end; ++it)
+        {
+            if (it->getCategory() == token::tokenCategory::BRACKET_OPEN)
             {
-                throwBadOperator();
+                ++depth;
             }
-            auto operatorExpression = std::make_shared<expression::FunctionCall>();
-            if (!operatorFunction_[operators.back().string])
+            else if (it->getCategory() == token::tokenCategory::BRACKET_CLOSE && depth-- == 0)
             {
-                throw std::invalid_argument("can not find operator " + operators.back().string);
+                report(exception::ErrorCode::BRACKET_DISBALANCE, it);
+                return false;
             }
-            operatorExpression->setFunction(operatorFunction_[operators.back().string]);
-            std::vector<expression::ExprShPtr> argumentExpressions{expressions.end() - arity, expressions.end()};
-            expressions.resize(expressions.size() - arity);
-            operatorExpression->setExpressions(std::move(argumentExpressions));
-            operators.pop_back();
-            expressions.emplace_back(std::move(operatorExpression));
-        };
-
-        auto popAssignment = [&]() {
-            if (operators.empty() ||
-                operators.back().category != token::tokenCategory::ASSIGNMENT ||
-                expressions.size() < 2)
+        }
+        for (std::size_t closed = 0; depth > 0;)
+        {
+            --end;
+            if (end->getCategory() == token::tokenCategory::BRACKET_CLOSE)
             {
-                throwBadOperator();
+                ++closed;
             }
-            auto rightExpr = expressions.back();
-            expressions.pop_back();
-            auto leftExpr = expressions.back();
-            expressions.pop_back();
-            if (!assignOperatorFunction_[operators.back().string])
+            else if (end->getCategory() == token::tokenCategory::BRACKET_OPEN && closed-- == 0)
             {
-                throw std::invalid_argument("can not find assignment operator " + operators.back().string);
+                report(exception::ErrorCode::BRACKET_DISBALANCE, end);
+                return false;
             }
-            auto assignExpr = std::make_shared<expression::AssignExpression>(leftExpr,
-                                                                             rightExpr,
-                                                                             assignOperatorFunction_[operators.back().string]);
-            operators.pop_back();
-            expressions.emplace_back(std::move(assignExpr));
-        };
+        }
+        return true;
+    }
 
-        auto popOperator = [&]() {
-            if (operators.empty())
+    // Pratt parser: parses expression from it, while its operators have at least minPriority, moves it after expression
+    // Operator of equal priority is parsed into right operand, so operators are right associative
+    // Missing expression is reported at blame token, which needs it
+    // Returns NO_NODE, if error is reported, parsing of line stops then
+    expression::node_t parseExpression(TokenIterator &it, TokenIterator end, int minPriority, TokenIterator blame, std::size_t depth)
+    {
+        if (depth == MAX_EXPRESSION_DEPTH)
+        {
+            throw std::length_error("expression is nested too deeply");
+        }
+        auto left = parseOperand(it, end, blame, depth);
+        while (left != expression::ExpressionArena::NO_NODE && it < end &&
+               (it->getCategory() == token::tokenCategory::OPERATOR_BI || it->getCategory() == token::tokenCategory::ASSIGNMENT))
+        {
+            const Operator &op = getOperator(it);
+            if (op.priority < minPriority)
             {
-                throwBadOperator();
+                break;
             }
-            switch (operators.back().category)
+            auto opIt = it;
+            it = getNextNonSepTokenIt(it + 1, end);
+            auto right = parseExpression(it, end, op.priority, opIt, depth + 1);
+            if (right == expression::ExpressionArena::NO_NODE)
             {
-            case token::tokenCategory::OPERATOR_UN:
-            case token::tokenCategory::OPERATOR_BI:
-                popArOperator(token::getTokenOperatorArity(operators.back().category));
-                break;
-            case token::tokenCategory::ASSIGNMENT:
-                popAssignment();
-                break;
-            case token::tokenCategory::BRACKET_OPEN:
-                exception::throwFromTokenIterator<exception::BracketDisbalanceError>(operators.back().position);
-                break;
-            default:
-                exception::throwFromTokenIterator<exception::UndefinedOperatorError>(operators.back().position);
+                return right;
             }
-        };
-
-        auto pushOperator = [&](const OperatorInfo &op) {
-            if (!operators.empty())
+            if (opIt->getCategory() != token::tokenCategory::ASSIGNMENT)
             {
-                while (!operators.empty() &&
-                       getOperatorPriority(operators.back().string) > getOperatorPriority(op.string))
-                {
-                    popOperator();
-                }
+                left = makeCall(op, left, right);
             }
-            operators.push_back(op);
-        };
+            else if (arena_->getNode(left).kind == expression::ExpressionArena::NodeKind::VARIABLE_ACCESS)
+            {
+                left = makeAssignment(op, left, right);
+            }
+            else
+            {
+                report(exception::ErrorCode::INVALID_ASSIGNATION, opIt);
+                return expression::ExpressionArena::NO_NODE;
+            }
+        }
+        return left;
+    }
+
+    // Parses value, name, bracket or unary operator with its operand, moves it after them
+    expression::node_t parseOperand(TokenIterator &it, TokenIterator end, TokenIterator blame, std::size_t depth)
+    {
+        if (it == end)
+        {
+            report(exception::ErrorCode::SYNTAX, blame);
+            return expression::ExpressionArena::NO_NODE;
+        }
+        auto tokenIt = it;
+        it = getNextNonSepTokenIt(it + 1, end);
+        switch (tokenIt->getCategory())
+        {
+        case token::tokenCategory::VALUE_INT:
+            return arena_->addValue(getInteger(*tokenIt));
+
+        case token::tokenCategory::NAME:
+            return arena_->addVariableAccess(getSymbol(*tokenIt));
 
-        for (; curIt < end; curIt = getNextNonSepTokenIt(curIt + 1, end))
+        case token::tokenCategory::OPERATOR_UN:
         {
-            auto &token = *curIt;
+            const Operator &op = getOperator(tokenIt);
+            auto operand = parseExpression(it, end, op.priority, tokenIt, depth + 1);
+            return operand == expression::ExpressionArena::NO_NODE ? operand : makeCall(op, operand);
+        }
 
-            switch (token->getCategory())
+        case token::tokenCategory::BRACKET_OPEN:
+        {
+            auto inner = parseExpression(it, end, 0, tokenIt, depth + 1);
+            if (inner == expression::ExpressionArena::NO_NODE)
             {
-            case token::tokenCategory::VALUE_INT:
-                expressions.push_back(std::make_shared<expression::VTypeValue>(std::stoi(token->getTokenString())));
-                break;
+                return inner;
+            }
+            if (it->getCategory() != token::tokenCategory::BRACKET_CLOSE) // brackets are balanced, so it < end
+            {
+                reportAfterExpression(it);
+                return expression::ExpressionArena::NO_NODE;
+            }
+            it = getNextNonSepTokenIt(it + 1, end);
+            return inner;
+        }
 
-            case token::tokenCategory::NAME:
-                expressions.push_back(std::make_shared<expression::VariableAccess>(token->getTokenString()));
-                break;
+        case token::tokenCategory::OPERATOR_BI:
+        case token::tokenCategory::ASSIGNMENT:
+        case token::tokenCategory::BRACKET_CLOSE:
+            report(exception::ErrorCode::SYNTAX, blame);
+            break;
 
-            case token::tokenCategory::ASSIGNMENT:
-            case token::tokenCategory::OPERATOR_UN:
-            case token::tokenCategory::OPERATOR_BI:
-                pushOperator({token->getTokenString(), token->getCategory(), curIt});
-                break;
+        default:
+            report(exception::ErrorCode::UNEXPECTED_TOKEN, tokenIt);
+            break;
+        }
+        return expression::ExpressionArena::NO_NODE;
+    }
 
-            case token::tokenCategory::BRACKET_OPEN:
-                operators.push_back({token->getTokenString(), token->getCategory(), curIt});
-                break;
+    // Reports error for token, which can not follow complete expression
+    void reportAfterExpression(TokenIterator it)
+    {
+        switch (it->getCategory())
+        {
+        case token::tokenCategory::VALUE_INT:
+        case token::tokenCategory::NAME:
+        case token::tokenCategory::OPERATOR_UN:
+        case token::tokenCategory::BRACKET_OPEN:
+            report(exception::ErrorCode::SYNTAX, it);
+            break;
+        default:
+            report(exception::ErrorCode::UNEXPECTED_TOKEN, it);
+        }
+    }
 
-            case token::tokenCategory::BRACKET_CLOSE:
-                while (!operators.empty() && operators.back().category != token::tokenCategory::BRACKET_OPEN)
-                {
-                    popOperator();
-                }
-                if (operators.empty())
-                {
-                    exception::throwFromTokenIterator<exception::BracketDisbalanceError>(curIt);
-                }
-                operators.pop_back();
-                break;
+    // Adds call of unary operator, if right is NO_NODE, of binary one otherwise
+    expression::node_t makeCall(const Operator &op, expression::node_t left, expression::node_t right = expression::ExpressionArena::NO_NODE)
+    {
+        std::size_t id = &op - operators_.data();
+        if (!functions_->calls[id])
+        {
+            throw std::invalid_argument("can not find operator " + op.string);
+        }
+        return arena_->addCall(id, left, right);
+    }
 
-            default:
-                exception::throwFromTokenIterator<exception::UnexpectedTokenError>(curIt);
-                break;
-            }
-            if (operators.empty())
-            {
-                if (expressions.size() != 1)
-                {
-                    exception::throwFromTokenIterator<exception::SyntaxError>(curIt);
-                }
-            }
+    expression::node_t makeAssignment(const Operator &op, expression::node_t left, expression::node_t right)
+    {
+        std::size_t id = &op - operators_.data();
+        if (!functions_->assignments[id])
+        {
+            throw std::invalid_argument("can not find assignment operator " + op.string);
+        }
+        return arena_->addAssignment(id, left, right);
+    }
+
+    // Returns operator of token
+    // Operator id, found by connected lexer, indexes flat table, tokens of not connected lexer are found by string
+    const Operator &getOperator(TokenIterator it) const
+    {
+        std::size_t operatorId = it->getOperatorId();
+        if (operatorId < operatorOfId_.size() && operatorOfId_[operatorId] != NO_ENTRY)
+        {
+            return operators_[operatorOfId_[operatorId]];
+        }
+        return findOperator(it->getTokenString());
+    }
+
+    // Returns operator with string, throws, if interpreter has not it
+    const Operator &findOperator(std::string_view string) const
+    {
+        auto op = std::find_if(operators_.begin(), operators_.end(), [&](const Operator &candidate) {
+            return candidate.string == string;
+        });
+        if (op == operators_.end())
+        {
+            throw std::invalid_argument("undefined operator " + std::string(string));
         }
-        while (!operators.empty())
+        return *op;
+    }
+
+    // Returns index of operator with string, adds it if it is new
+    std::size_t addOperator(const std::string &string)
+    {
+        auto op = std::find_if(operators_.begin(), operators_.end(), [&](const Operator &candidate) {
+            return candidate.string == string;
+        });
+        if (op != operators_.end())
         {
-            popOperator();
+            return op - operators_.begin();
         }
-        if (expressions.size() != 1)
+        if (operators_.size() >= NO_ENTRY)
         {
-            exception::throwFromTokenIterator<exception::SyntaxError>(begin);
+            throw std::length_error("too many operators in interpreter");
         }
-        return expressions[0];
+        operators_.emplace_back();
+        operators_.back().string = string;
+        functions_->calls.emplace_back();
+        functions_->assignments.emplace_back();
+        functions_->callBuiltins.push_back(expression::BuiltinOperator::NONE);
+        functions_->assignmentBuiltins.push_back(expression::BuiltinOperator::NONE);
+        return operators_.size() - 1;
     }
 
-    int getOperatorPriority(const std::string &op)
+    // Returns symbol of name, interned by lexer
+    // Name is interned here, if lexer has no symbol table, workers only find names interned before they start
+    token::symbol_t getSymbol(const token::Token &name)
     {
-        if (op == "(")
+        token::symbol_t symbol = name.getSymbol();
+        if (symbol != token::SymbolTable::NO_SYMBOL)
         {
-            return 0;
+            return symbol;
         }
+        if (!internNames_)
+        {
+            symbol = symbols_->find(name.getTokenString());
+            if (symbol == token::SymbolTable::NO_SYMBOL)
+            {
+                throw std::logic_error("name is not interned before building");
+            }
+            return symbol;
+        }
+        return symbols_->intern(name.getTokenString());
+    }
 
-        if (operatorPriority_.find(op) == operatorPriority_.end())
+    // Returns value of integer literal, decoded by lexer
+    // Literal is decoded here, if lexer has no decoder for its category
+    static expression::VType getInteger(const token::Token &literal)
+    {
+        const token::LiteralValue *decoded = literal.getLiteral();
+        token::LiteralValue value = decoded ? *decoded : token::LiteralDecoder::integer().decode(literal.getTokenString());
+        if (auto error = std::get_if<token::LiteralError>(&value))
+        {
+            if (*error == token::LiteralError::OUT_OF_RANGE)
+            {
+                throw std::out_of_range("integer literal is out of range");
+            }
+            throw std::invalid_argument("invalid integer literal");
+        }
+        auto integer = std::get_if<std::int64_t>(&value);
+        if (!integer)
+        {
+            throw std::invalid_argument("invalid integer literal");
+        }
+        if (*integer < std::numeric_limits<expression::VType>::min() || *integer > std::numeric_limits<expression::VType>::max())
         {
-            throw std::invalid_argument("undefined operator " + op);
+            throw std::out_of_range("integer literal is out of range");
         }
-        return operatorPriority_[op];
+        return static_cast<expression::VType>(*integer);
     }
 
     std::vector<token::tokenCategory_t> singleIndentationBlock_;
     std::stack<UnfinishedExpression> unfinishedExpressions_;
-    std::unordered_map<std::string, int> operatorPriority_;
-    std::unordered_map<std::string, expression::FunctionCall::FunctionType> operatorFunction_;
-    std::unordered_map<std::string, expression::AssignExpression::FunctionType> assignOperatorFunction_;
+    std::vector<Operator> operators_;          // operators in constructor order
+    std::vector<std::uint16_t> operatorOfId_;  // index of operator of each operator id of connected lexer
+    std::shared_ptr<expression::OperatorFunctions> functions_ = std::make_shared<expression::OperatorFunctions>(); // functions of operators
+    std::shared_ptr<expression::ExpressionArena> arena_;                                                             // arena of built expressions
+    bool internNames_ = true;                                                                                        // if names without symbol may be interned
+    std::optional<exception::Diagnostic> error_;                                                                     // the first error of current line
+    std::shared_ptr<token::SymbolTable> symbols_ = std::make_shared<token::SymbolTable>(); // table of variable names
 }; // namespace interpreter
 } // namespace interpreter
 } // namespace peach
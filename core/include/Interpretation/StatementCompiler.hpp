@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "Expression.hpp"
+#include "Interpreter.hpp"
+#include "Lexer.hpp"
+#include "TokenBuffer.hpp"
+
+namespace peach
+{
+namespace interpreter
+{
+// Compiles program, which comes line by line, into top level statements
+// Statement is line without indentation (except 'else' one) with all following lines, which are indented,
+// blank or 'else' ones. Statement is finished, when the next one begins or program ends.
+// Statement without 'if' or 'while' header can not be continued, so it is finished right after its line.
+// Every statement is built in its own arena, only tokens of the current line are kept.
+// If line of statement is broken, statement gets error and its other lines are skipped.
+// Tokens of lexer must not span several lines.
+class StatementCompiler
+{
+public:
+    // Finished statement: its expression or its error
+    struct Statement
+    {
+        expression::ExprShPtr expression;
+        std::exception_ptr error;
+    };
+
+    StatementCompiler(std::shared_ptr<const fsm::Lexer> lexer, Interpreter interpreter)
+        : lexer_(std::move(lexer)),
+          interpreter_(std::move(interpreter))
+    {
+        if (!lexer_)
+        {
+            throw std::invalid_argument("nullptr lexer in StatementCompiler constructor");
+        }
+    }
+
+    // Compiles next line of program, line must not contain line end
+    // Appends statements, which are finished by line, to finished
+    void pushLine(std::string_view line, std::vector<Statement> &finished)
+    {
+        std::size_t depthBefore = depth_;
+        bool beginsStatement = false, hasCode = false, isHeader = false;
+        try
+        {
+            tokens_.reset(line);
+            tokens_.setFirstLine(lineNumber_++);
+            lexer_->tokenizeLine(tokens_, depth_, interpreter_.getSymbolTable().get());
+            auto code = getCodeBegin();
+            hasCode = code < tokens_.end();
+            beginsStatement = hasCode && depth_ == 0 && code->getCategory() != token::tokenCategory::COND_ELSE;
+            isHeader = beginsStatement && (code->getCategory() == token::tokenCategory::COND_IF ||
+                                           code->getCategory() == token::tokenCategory::LOOP_WHILE);
+        }
+        catch (...)
+        {
+            fail(finished);
+            return;
+        }
+        if (beginsStatement)
+        {
+            finish(finished);
+        }
+        if (broken_ || !hasCode)
+        {
+            return; // blank lines do not change interpreter
+        }
+        try
+        {
+            interpreter_.interpretateLines(tokens_.begin(), tokens_.end(), depthBefore);
+            open_ = true;
+        }
+        catch (...)
+        {
+            fail(finished);
+            return;
+        }
+        if (beginsStatement && !isHeader)
+        {
+            finish(finished);
+        }
+    }
+
+    // Finishes the last statement of program, it is appended to finished
+    void finish(std::vector<Statement> &finished)
+    {
+        if (open_)
+        {
+            try
+            {
+                finished.push_back({interpreter_.getInterpretationResult(), nullptr});
+            }
+            catch (...)
+            {
+                finished.push_back({nullptr, std::current_exception()});
+            }
+            interpreter_.reset();
+        }
+        open_ = false;
+        broken_ = false;
+    }
+
+    const std::shared_ptr<token::SymbolTable> &getSymbolTable() const noexcept
+    {
+        return interpreter_.getSymbolTable();
+    }
+
+private:
+    // Appends error of current statement, its next lines are skipped
+    void fail(std::vector<Statement> &finished)
+    {
+        finished.push_back({nullptr, std::current_exception()});
+        interpreter_.reset();
+        open_ = false;
+        broken_ = true;
+    }
+
+    // Returns the first token of line after indentation
+    TokenIterator getCodeBegin() const
+    {
+        const auto &block = lexer_->getIndentationBlock();
+        auto it = tokens_.begin();
+        for (; it < tokens_.end() && (token::isIndentation(*it) ||
+                                      std::find(block.begin(), block.end(), it->getCategory()) != block.end());
+             ++it)
+            ;
+        return it;
+    }
+
+    std::shared_ptr<const fsm::Lexer> lexer_; // lexer with indentation tracking
+    Interpreter interpreter_;                 // interpreter of current statement
+    token::TokenBuffer tokens_;               // tokens of current line
+    std::size_t lineNumber_ = 0;              // number of next line
+    std::size_t depth_ = 0;                   // indentation depth of lexer after current line
+    bool open_ = false;                       // if current statement has interpreted lines
+    bool broken_ = false;                     // if current statement has error
+};
+} // namespace interpreter
+} // namespace peach
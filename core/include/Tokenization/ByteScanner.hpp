@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Transition.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define PEACH_SCANNER_X86 1
+#endif
+
+namespace peach
+{
+namespace fsm
+{
+// Set of bytes, stored as at most MAX_RANGES ranges
+// Finds where run of set bytes ends: with AVX2 or SSE2 if processor supports it, byte by byte otherwise
+// Set can be built at compile time
+class ByteRangeSet
+{
+public:
+    static constexpr std::size_t MAX_RANGES = 4;
+
+    constexpr ByteRangeSet() = default;
+
+    // Builds set from set of chars
+    // If chars can not be represented with MAX_RANGES ranges, set stays empty
+    constexpr explicit ByteRangeSet(const transition::CharSet &chars)
+    {
+        std::size_t count = 0;
+        for (std::size_t byte = 0; byte < 256;)
+        {
+            if (!chars.contains(static_cast<char>(byte)))
+            {
+                ++byte;
+                continue;
+            }
+            std::size_t last = byte;
+            while (last + 1 < 256 && chars.contains(static_cast<char>(last + 1)))
+            {
+                ++last;
+            }
+            if (count == MAX_RANGES)
+            {
+                return;
+            }
+            begins_[count] = static_cast<std::uint8_t>(byte);
+            widths_[count] = static_cast<std::uint8_t>(last - byte);
+            ++count;
+            byte = last + 1;
+        }
+        rangesCount_ = count;
+        bytes_ = chars;
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return rangesCount_ == 0;
+    }
+
+    constexpr bool contains(char c) const noexcept
+    {
+        return bytes_.contains(c);
+    }
+
+    // Returns length of the longest prefix of [begin, end), all chars of which are in set
+    // Short runs are usual, so the first char is checked before vectorized scan
+    std::size_t findRunLength(const char *begin, const char *end) const noexcept
+    {
+        if (begin == end || !contains(*begin))
+        {
+            return 0;
+        }
+#ifdef PEACH_SCANNER_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return 1 + scanAvx2(*this, begin + 1, end);
+        }
+        return 1 + scanSse2(*this, begin + 1, end);
+#else
+        return 1 + scanScalar(*this, begin + 1, end);
+#endif
+    }
+
+private:
+    static std::size_t scanScalar(const ByteRangeSet &set, const char *begin, const char *end) noexcept
+    {
+        const char *cur = begin;
+        while (cur < end && set.contains(*cur))
+        {
+            ++cur;
+        }
+        return cur - begin;
+    }
+
+#ifdef PEACH_SCANNER_X86
+    static std::size_t scanSse2(const ByteRangeSet &set, const char *begin, const char *end) noexcept
+    {
+        const char *cur = begin;
+        for (; end - cur >= 16; cur += 16)
+        {
+            __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cur));
+            __m128i inSet = _mm_setzero_si128();
+            for (std::size_t range = 0; range < set.rangesCount_; ++range)
+            {
+                // c is in [begin, begin + width] iff unsigned (c - begin) <= width
+                __m128i shifted = _mm_sub_epi8(chars, _mm_set1_epi8(static_cast<char>(set.begins_[range])));
+                __m128i clamped = _mm_min_epu8(shifted, _mm_set1_epi8(static_cast<char>(set.widths_[range])));
+                inSet = _mm_or_si128(inSet, _mm_cmpeq_epi8(shifted, clamped));
+            }
+            unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(inSet)) & 0xFFFFu;
+            if (mask)
+            {
+                return cur - begin + __builtin_ctz(mask);
+            }
+        }
+        return cur - begin + scanScalar(set, cur, end);
+    }
+
+    __attribute__((target("avx2"))) static std::size_t scanAvx2(const ByteRangeSet &set, const char *begin, const char *end) noexcept
+    {
+        const char *cur = begin;
+        for (; end - cur >= 32; cur += 32)
+        {
+            __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cur));
+            __m256i inSet = _mm256_setzero_si256();
+            for (std::size_t range = 0; range < set.rangesCount_; ++range)
+            {
+                __m256i shifted = _mm256_sub_epi8(chars, _mm256_set1_epi8(static_cast<char>(set.begins_[range])));
+                __m256i clamped = _mm256_min_epu8(shifted, _mm256_set1_epi8(static_cast<char>(set.widths_[range])));
+                inSet = _mm256_or_si256(inSet, _mm256_cmpeq_epi8(shifted, clamped));
+            }
+            unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(inSet));
+            if (mask)
+            {
+                return cur - begin + __builtin_ctz(mask);
+            }
+        }
+        return cur - begin + scanSse2(set, cur, end);
+    }
+#endif
+
+    std::array<std::uint8_t, MAX_RANGES> begins_{}; // first byte of each range
+    std::array<std::uint8_t, MAX_RANGES> widths_{}; // last byte minus first byte of each range
+    std::size_t rangesCount_ = 0;                   // number of ranges
+    transition::CharSet bytes_;                     // all bytes of set
+};
+} // namespace fsm
+} // namespace peach
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "FiniteStateMachine.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Cell of dense transition table
+// Values less than ACCEPT are states, REJECT means no transition.
+// Accept cell means terminal has been reached: ACCEPT | (operator id + 1) << OPERATOR_SHIFT | category,
+// terminals without operator id have 0 in place of it, so their cell is ACCEPT | category.
+using state_t = std::uint16_t;
+
+namespace table
+{
+static constexpr state_t ACCEPT = 0x8000;
+static constexpr state_t REJECT = 0xFFFF;
+static constexpr std::size_t MAX_STATES = ACCEPT;
+static constexpr std::size_t BYTES_TOTAL = 256;
+static constexpr std::size_t OPERATOR_SHIFT = 8;
+static constexpr token::tokenCategory_t MAX_ACCEPT_CATEGORY = (1 << OPERATOR_SHIFT) - 1;
+static constexpr std::size_t MAX_OPERATORS = (ACCEPT >> OPERATOR_SHIFT) - 2; // so accept cell is never REJECT
+
+inline constexpr bool isState(state_t cell) noexcept
+{
+    return cell < ACCEPT;
+}
+
+inline constexpr bool isAccept(state_t cell) noexcept
+{
+    return cell != REJECT && (cell & ACCEPT);
+}
+
+inline constexpr token::tokenCategory_t getAcceptCategory(state_t cell) noexcept
+{
+    return cell & MAX_ACCEPT_CATEGORY;
+}
+
+// Returns operator id of terminal, token::NO_OPERATOR if it has no id
+inline constexpr std::size_t getAcceptOperator(state_t cell) noexcept
+{
+    std::size_t tag = (cell & ~ACCEPT) >> OPERATOR_SHIFT;
+    return tag == 0 ? token::NO_OPERATOR : tag - 1;
+}
+
+// Category must not exceed MAX_ACCEPT_CATEGORY, operator id must be less than MAX_OPERATORS or token::NO_OPERATOR
+inline constexpr state_t makeAccept(token::tokenCategory_t category, std::size_t operatorId = token::NO_OPERATOR) noexcept
+{
+    std::size_t tag = operatorId == token::NO_OPERATOR ? 0 : operatorId + 1;
+    return static_cast<state_t>(ACCEPT | tag << OPERATOR_SHIFT | category);
+}
+} // namespace table
+
+// Maps every byte to its equivalence class
+// Two bytes are equivalent iff no table can distinguish them
+class ByteClassMap
+{
+public:
+    ByteClassMap()
+    {
+        classOf_.fill(0);
+    }
+
+    std::uint8_t operator[](char c) const noexcept
+    {
+        return classOf_[static_cast<unsigned char>(c)];
+    }
+
+    std::size_t getClassCount() const noexcept
+    {
+        return classCount_;
+    }
+
+    const std::array<std::uint8_t, table::BYTES_TOTAL> &getClasses() const noexcept
+    {
+        return classOf_;
+    }
+
+    // Builds classes from byte columns: bytes with equal columns share the class
+    // Classes are numbered in order of first byte occurence
+    template <typename Column>
+    static ByteClassMap fromColumns(const std::array<Column, table::BYTES_TOTAL> &columns)
+    {
+        ByteClassMap result;
+        std::map<Column, std::uint8_t> classes;
+        for (std::size_t byte = 0; byte < table::BYTES_TOTAL; ++byte)
+        {
+            auto [it, inserted] = classes.emplace(columns[byte], static_cast<std::uint8_t>(classes.size()));
+            result.classOf_[byte] = it->second;
+        }
+        result.classCount_ = classes.size();
+        return result;
+    }
+
+    // Returns any byte of class cls
+    unsigned char getRepresentative(std::uint8_t cls) const
+    {
+        for (std::size_t byte = 0; byte < table::BYTES_TOTAL; ++byte)
+        {
+            if (classOf_[byte] == cls)
+            {
+                return static_cast<unsigned char>(byte);
+            }
+        }
+        throw std::out_of_range("byte class does not exist");
+    }
+
+private:
+    std::array<std::uint8_t, table::BYTES_TOTAL> classOf_;
+    std::size_t classCount_ = 1;
+};
+
+// Finite state machine lowered into dense table next[state][byteClass]
+// State 0 is the root
+class CompiledFsm
+{
+public:
+    CompiledFsm(std::vector<state_t> cells, std::size_t classCount)
+        : table_(std::move(cells)),
+          classCount_(classCount)
+    {
+    }
+
+    state_t getNext(state_t state, std::uint8_t cls) const noexcept
+    {
+        return table_[state * classCount_ + cls];
+    }
+
+    std::size_t getStateCount() const noexcept
+    {
+        return table_.size() / classCount_;
+    }
+
+private:
+    std::vector<state_t> table_;
+    std::size_t classCount_;
+};
+
+namespace details
+{
+// Table of single machine over all bytes, before byte classes are known
+using RawTable = std::vector<std::array<state_t, table::BYTES_TOTAL>>;
+
+// Walks node graph from root, enumerates non-terminal nodes
+// Returns raw table, where root is state 0
+inline RawTable buildRawTable(const FiniteStateMachine &machine)
+{
+    RawTable raw;
+    std::unordered_map<const Node *, state_t> stateOf;
+    std::vector<std::shared_ptr<Node>> queue = {machine.getRoot()};
+    stateOf[queue.front().get()] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head)
+    {
+        auto node = queue[head];
+        raw.emplace_back();
+        for (std::size_t byte = 0; byte < table::BYTES_TOTAL; ++byte)
+        {
+            auto next = node->getNextNode(static_cast<char>(byte));
+            state_t cell = table::REJECT;
+            if (next && next->isTerminal())
+            {
+                if (head == 0)
+                {
+                    throw std::invalid_argument("root node can not lead to terminal: empty tokens are not allowed");
+                }
+                if (next->gettokenCategory_t() > table::MAX_ACCEPT_CATEGORY)
+                {
+                    throw std::invalid_argument("token category is too large to be compiled");
+                }
+                cell = table::makeAccept(next->gettokenCategory_t(), next->getOperatorId());
+            }
+            else if (next)
+            {
+                auto [it, inserted] = stateOf.emplace(next.get(), static_cast<state_t>(queue.size()));
+                if (inserted)
+                {
+                    if (queue.size() >= table::MAX_STATES)
+                    {
+                        throw std::length_error("finite state machine has too many states to be compiled");
+                    }
+                    queue.push_back(next);
+                }
+                cell = it->second;
+            }
+            raw.back()[byte] = cell;
+        }
+    }
+    return raw;
+}
+
+// Merges equivalent states with Moore's partition refinement
+// Returns minimized table, where root is state 0
+inline std::vector<state_t> minimize(const std::vector<state_t> &cells, std::size_t classCount)
+{
+    std::size_t stateCount = cells.size() / classCount;
+    std::vector<std::size_t> blockOf(stateCount, 0);
+    std::size_t blockCount = 1;
+    while (true)
+    {
+        std::map<std::vector<std::size_t>, std::size_t> blocks;
+        std::vector<std::size_t> newBlockOf(stateCount);
+        for (std::size_t state = 0; state < stateCount; ++state)
+        {
+            std::vector<std::size_t> signature = {blockOf[state]};
+            for (std::size_t cls = 0; cls < classCount; ++cls)
+            {
+                state_t cell = cells[state * classCount + cls];
+                signature.push_back(table::isState(cell) ? blockOf[cell] : table::MAX_STATES + cell);
+            }
+            newBlockOf[state] = blocks.emplace(std::move(signature), blocks.size()).first->second;
+        }
+        blockOf = std::move(newBlockOf);
+        if (blocks.size() == blockCount)
+        {
+            break;
+        }
+        blockCount = blocks.size();
+    }
+
+    // Root block gets number 0, others are numbered in order of first occurence
+    std::vector<state_t> stateOfBlock(blockCount, table::REJECT);
+    std::vector<std::size_t> representative;
+    for (std::size_t state = 0; state < stateCount; ++state)
+    {
+        if (stateOfBlock[blockOf[state]] == table::REJECT)
+        {
+            stateOfBlock[blockOf[state]] = static_cast<state_t>(representative.size());
+            representative.push_back(state);
+        }
+    }
+    std::vector<state_t> result;
+    result.reserve(blockCount * classCount);
+    for (std::size_t state : representative)
+    {
+        for (std::size_t cls = 0; cls < classCount; ++cls)
+        {
+            state_t cell = cells[state * classCount + cls];
+            result.push_back(table::isState(cell) ? stateOfBlock[blockOf[cell]] : cell);
+        }
+    }
+    return result;
+}
+} // namespace details
+
+// Lowers machines into minimized dense tables with common byte classes
+// Returns pair of [byte classes; compiled machines in the same order]
+inline std::pair<ByteClassMap, std::vector<CompiledFsm>> compileMachines(const std::vector<const FiniteStateMachine *> &machines)
+{
+    std::vector<details::RawTable> raws;
+    for (const auto *machine : machines)
+    {
+        raws.push_back(details::buildRawTable(*machine));
+    }
+
+    std::array<std::vector<state_t>, table::BYTES_TOTAL> columns;
+    for (const auto &raw : raws)
+    {
+        for (const auto &row : raw)
+        {
+            for (std::size_t byte = 0; byte < table::BYTES_TOTAL; ++byte)
+            {
+                columns[byte].push_back(row[byte]);
+            }
+        }
+    }
+    auto classes = ByteClassMap::fromColumns(columns);
+    std::vector<unsigned char> representatives;
+    for (std::size_t cls = 0; cls < classes.getClassCount(); ++cls)
+    {
+        representatives.push_back(classes.getRepresentative(static_cast<std::uint8_t>(cls)));
+    }
+
+    std::vector<CompiledFsm> compiled;
+    for (const auto &raw : raws)
+    {
+        std::vector<state_t> cells;
+        cells.reserve(raw.size() * classes.getClassCount());
+        for (const auto &row : raw)
+        {
+            for (unsigned char byte : representatives)
+            {
+                cells.push_back(row[byte]);
+            }
+        }
+        compiled.emplace_back(details::minimize(cells, classes.getClassCount()), classes.getClassCount());
+    }
+    return {classes, std::move(compiled)};
+}
+} // namespace fsm
+} // namespace peach
@@ -11,6 +11,7 @@ namespace fsm
 {
 // Finite state machine, finds string literals.
 // escaped characters: [escaped, real]
+// Literals are decoded without quotes, when they are lexed
 template <char Separator>
 class LiteralFinder : public FiniteStateMachine
 {
@@ -22,6 +23,7 @@ public:
         node->template addTransition<transition::TransitionNegation<transition::SingleCharTransitionTemplate<Separator>>>(node);
         auto terminal = node->template addTransitionToNewNode<transition::SingleCharTransitionTemplate<Separator>>(token::tokenCategory::UNDEFINED);
         terminal->template addTransitionToNewNode<transition::TrueTransition>(category);
+        addLiteralDecoder(category, token::LiteralDecoder::string(Separator));
     }
 };
 } // namespace fsm
@@ -4,6 +4,7 @@
 #include <cassert>
 
 #include "FiniteStateMachine.hpp"
+#include "StaticFsm.hpp"
 
 namespace peach
 {
@@ -20,5 +21,15 @@ public:
         firstNode->addTransitionToNewNode<transition::TransitionNegation<transition::LatinUnderscoreDigitTransition>>(token::tokenCategory::NAME);
     }
 };
+
+// Returns NameFinder graph, built at compile time
+constexpr StaticFsm<3> makeStaticNameFinder()
+{
+    StaticFsm<3> machine;
+    auto firstNode = machine.addTransitionToNewNode<transition::LatinUnderscoreTransition>(0, token::tokenCategory::UNDEFINED);
+    machine.addTransition<transition::LatinUnderscoreDigitTransition>(firstNode, firstNode);
+    machine.addTransitionToNewNode<transition::TransitionNegation<transition::LatinUnderscoreDigitTransition>>(firstNode, token::tokenCategory::NAME);
+    return machine;
+}
 } // namespace fsm
 } // namespace peach
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FiniteStateMachine.hpp"
+#include "StaticFsm.hpp"
 
 namespace peach
 {
@@ -9,6 +10,7 @@ namespace fsm
 // Finite state machine, finds number-like tokens
 // decimalSeparator (usually dot or comma) - separates integer and fractional parts. Can't be digit.
 // lastCharacter - character, that numbers of this type has, like d for double in C++ or f for float
+// Numbers without lastCharacter are decoded, when they are lexed
 class NumberFinder : public FiniteStateMachine
 {
 public:
@@ -18,6 +20,7 @@ public:
         auto firstNode = addMinusOrDigitTransitionToNewNode(getRoot());
         addDigitLoop(firstNode);
         firstNode->addTransitionToNewNode<transition::TransitionNegation<transition::DigitCharTransition>>(category);
+        addLiteralDecoder(category, token::LiteralDecoder::integer());
     }
 
     // For floating point number without lastCharacter
@@ -32,6 +35,7 @@ public:
         auto secondNode = firstNode->addTransitionToNewNode<transition::SingleCharTransition>(token::tokenCategory::UNDEFINED, decimalSeparator);
         addDigitLoop(secondNode);
         secondNode->addTransitionToNewNode<transition::TransitionNegation<transition::DigitCharTransition>>(category);
+        addLiteralDecoder(category, token::LiteralDecoder::floating(decimalSeparator));
     }
 
     // For integer with lastCharacter
@@ -97,5 +101,38 @@ private:
         return term;
     }
 };
+
+// Returns NumberFinder graph for integer without lastCharacter, built at compile time
+constexpr StaticFsm<4> makeStaticNumberFinder(token::tokenCategory_t category)
+{
+    StaticFsm<4> machine;
+    auto minusNode = machine.addTransitionToNewNode<transition::SingleCharTransitionTemplate<'-'>>(0, token::tokenCategory::UNDEFINED);
+    auto firstNode = machine.addTransitionToNewNode<transition::DigitCharTransition>(minusNode, token::tokenCategory::UNDEFINED);
+    machine.addTransition<transition::DigitCharTransition>(0, firstNode);
+    machine.addTransition<transition::DigitCharTransition>(firstNode, firstNode);
+    machine.addTransitionToNewNode<transition::TransitionNegation<transition::DigitCharTransition>>(firstNode, category);
+    machine.setLiteralDecoder(category, token::LiteralDecoder::integer());
+    return machine;
+}
+
+// Returns NumberFinder graph for floating point number without lastCharacter, built at compile time
+constexpr StaticFsm<5> makeStaticNumberFinder(token::tokenCategory_t category, char decimalSeparator)
+{
+    if ('0' <= decimalSeparator && decimalSeparator <= '9')
+    {
+        throw std::invalid_argument("decimalSeparator can not be a digit");
+    }
+    StaticFsm<5> machine;
+    auto minusNode = machine.addTransitionToNewNode<transition::SingleCharTransitionTemplate<'-'>>(0, token::tokenCategory::UNDEFINED);
+    auto firstNode = machine.addTransitionToNewNode<transition::DigitCharTransition>(minusNode, token::tokenCategory::UNDEFINED);
+    machine.addTransition<transition::DigitCharTransition>(0, firstNode);
+    machine.addTransition<transition::DigitCharTransition>(firstNode, firstNode);
+    auto secondNode = machine.addNode(token::tokenCategory::UNDEFINED);
+    machine.addTransition(firstNode, transition::CharSet::single(decimalSeparator), secondNode);
+    machine.addTransition<transition::DigitCharTransition>(secondNode, secondNode);
+    machine.addTransitionToNewNode<transition::TransitionNegation<transition::DigitCharTransition>>(secondNode, category);
+    machine.setLiteralDecoder(category, token::LiteralDecoder::floating(decimalSeparator));
+    return machine;
+}
 } // namespace fsm
 } // namespace peach
@@ -2,14 +2,18 @@
 
 #include <array>
 #include <stdexcept>
+#include <string_view>
 
+#include "CompiledFsm.hpp"
 #include "FiniteStateMachine.hpp"
+#include "StaticFsm.hpp"
 
 namespace peach
 {
 namespace fsm
 {
 // Finite state machine, finds tokens with category tokenCategory::OPERATOR
+// Patterns get dense operator ids in adding order, their tokens carry them
 class OperatorFinder : public FiniteStateMachine
 {
 public:
@@ -28,6 +32,10 @@ public:
         {
             throw std::invalid_argument("pattern must contain at least one character");
         }
+        if (operatorCount_ == table::MAX_OPERATORS)
+        {
+            throw std::length_error("too many operator patterns");
+        }
         auto curNode = getRoot();
         std::array<std::unique_ptr<transition::CharTransition>, 2> badTransitions =
             {std::make_unique<transition::LatinUnderscoreDigitTransition>(),
@@ -50,8 +58,50 @@ public:
                 curNode = curNode->addTransitionToNewNode<transition::SingleCharTransition>(token::tokenCategory::UNDEFINED, c);
             }
         }
-        curNode->addTransitionToNewNode<transition::TrueTransition>(category);
+        curNode->addTransitionToNewNode<transition::TrueTransition>(category)->setOperatorId(operatorCount_++);
     }
+
+private:
+    std::size_t operatorCount_ = 0;
 };
+
+// Returns OperatorFinder graph, built at compile time
+// MaxNodes must be at least 1 + total length of patterns + number of patterns
+// Patterns get operator ids in order of the list
+template <std::size_t MaxNodes = 64, std::size_t N>
+constexpr StaticFsm<MaxNodes> makeStaticOperatorFinder(const std::pair<std::string_view, token::tokenCategory_t> (&operators)[N])
+{
+    if (N > table::MAX_OPERATORS)
+    {
+        throw std::length_error("too many operator patterns");
+    }
+    StaticFsm<MaxNodes> machine;
+    for (std::size_t operatorId = 0; operatorId < N; ++operatorId)
+    {
+        const auto &[pattern, category] = operators[operatorId];
+        if (pattern.empty())
+        {
+            throw std::invalid_argument("pattern must contain at least one character");
+        }
+        std::size_t curNode = 0;
+        for (char c : pattern)
+        {
+            if (transition::LatinUnderscoreDigitTransition::contains(c) || c == ' ' || c == '\n' || c == '\t')
+            {
+                throw std::invalid_argument("character is not allowed in operators");
+            }
+            std::size_t nextNode = machine.getNextNode(curNode, c);
+            if (nextNode == machine.NONE)
+            {
+                nextNode = machine.addNode(token::tokenCategory::UNDEFINED);
+                machine.addTransition(curNode, transition::CharSet::single(c), nextNode);
+            }
+            curNode = nextNode;
+        }
+        std::size_t terminal = machine.template addTransitionToNewNode<transition::TrueTransition>(curNode, category);
+        machine.setOperatorId(terminal, operatorId);
+    }
+    return machine;
+}
 } // namespace fsm
 } // namespace peach
@@ -4,6 +4,7 @@
 #include <cassert>
 
 #include "FiniteStateMachine.hpp"
+#include "StaticFsm.hpp"
 
 namespace peach
 {
@@ -22,5 +23,19 @@ public:
         }
     }
 };
+
+// Returns SingleCharFinder graph, built at compile time
+template <std::size_t N>
+constexpr StaticFsm<2 * N + 1> makeStaticSingleCharFinder(const std::pair<char, token::tokenCategory_t> (&chars)[N])
+{
+    StaticFsm<2 * N + 1> machine;
+    for (const auto &[ch, category] : chars)
+    {
+        auto charNode = machine.addNode(token::tokenCategory::UNDEFINED);
+        machine.addTransition(0, transition::CharSet::single(ch), charNode);
+        machine.template addTransitionToNewNode<transition::TrueTransition>(charNode, category);
+    }
+    return machine;
+}
 } // namespace fsm
 } // namespace peach
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include "Literal.hpp"
 #include "Token.hpp"
 #include "Transition.hpp"
 
@@ -32,7 +34,7 @@ public:
         return newNode;
     }
 
-    std::shared_ptr<Node> getNextNode(char c)
+    std::shared_ptr<Node> getNextNode(char c) const
     {
         for (auto &&[transition, node] : transitions_)
         {
@@ -54,17 +56,31 @@ public:
         return category_;
     }
 
+    // Tokens of terminal node get operator id, lexer passes it to interpreter
+    void setOperatorId(std::size_t operatorId) noexcept
+    {
+        operatorId_ = operatorId;
+    }
+
+    std::size_t getOperatorId() const noexcept
+    {
+        return operatorId_;
+    }
+
 private:
     std::vector<std::pair<std::unique_ptr<transition::CharTransition>, std::shared_ptr<Node>>> transitions_;
     token::tokenCategory_t category_;
+    std::size_t operatorId_ = token::NO_OPERATOR;
 };
 
+// Graph of finite state machine, which finds tokens of some categories
+// Machine has no position in text: graph is only a description, which is compiled into lexer automaton.
+// Lexer keeps position of every tokenization in its own cursor.
 class FiniteStateMachine
 {
 public:
     FiniteStateMachine()
-        : root_(std::make_shared<Node>()),
-          curNode_(root_)
+        : root_(std::make_shared<Node>())
     {
     }
 
@@ -73,39 +89,22 @@ public:
         return root_;
     }
 
-    std::shared_ptr<Node> getCurrentNode() const noexcept
+    // Returns categories of literal tokens, which machine finds, with their decoders
+    const std::vector<std::pair<token::tokenCategory_t, token::LiteralDecoder>> &getLiteralDecoders() const noexcept
     {
-        return curNode_;
+        return literalDecoders_;
     }
 
-    // Follows char according to inner graph. If transition can not be processed, current node assigns to root
-    // Returns pair of [was push successfull; category of current node].
-    // Current node resets to root if terminal has been reached.
-    std::pair<bool, token::tokenCategory_t> pushChar(char c)
+protected:
+    // Tokens of category will be decoded with decoder, when they are lexed
+    void addLiteralDecoder(token::tokenCategory_t category, token::LiteralDecoder decoder)
     {
-        auto nextNode = curNode_->getNextNode(c);
-        token::tokenCategory_t prevNodeCategory = curNode_->gettokenCategory_t();
-        bool success = true;
-        if (!nextNode)
-        {
-            curNode_ = root_;
-            success = false;
-        }
-        else
-        {
-            curNode_ = nextNode;
-            if (curNode_->isTerminal())
-            {
-                prevNodeCategory = curNode_->gettokenCategory_t();
-                curNode_ = root_;
-            }
-        }
-        return {success, prevNodeCategory};
+        literalDecoders_.emplace_back(category, decoder);
     }
 
 private:
     std::shared_ptr<Node> root_;
-    std::shared_ptr<Node> curNode_;
+    std::vector<std::pair<token::tokenCategory_t, token::LiteralDecoder>> literalDecoders_;
 };
 } // namespace fsm
 } // namespace peach
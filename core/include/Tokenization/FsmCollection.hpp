@@ -1,26 +1,55 @@
 #pragma once
 
+#include <memory>
+#include <string_view>
 #include <vector>
 
+#include "CompiledFsm.hpp"
 #include "FiniteStateMachine.hpp"
+#include "KeywordTable.hpp"
+#include "Lexer.hpp"
+#include "LexerAutomaton.hpp"
+#include "SymbolTable.hpp"
+#include "ThreadPool.hpp"
+#include "TokenBuffer.hpp"
 
 namespace peach
 {
 namespace fsm
 {
 // Collection of FiniteStateMachines
-// First attach FSMs, then tokenize text
+// First attach FSMs, then tokenize text. Or use automaton, precompiled from StaticLexerTables.
 // Uses FSMs in order, they were attached to collection
+// Before tokenization FSMs are lowered into single product automaton, which runs all of them in lockstep.
+// Collection is a builder of immutable Lexer, which does tokenization itself.
+// Large texts can be tokenized in parallel by chunks of lines.
+// If collection has symbol table, names are interned into it, so name tokens carry symbol ids.
+// If collection has indentation block, lexer tracks indentation depth and emits INDENT and DEDENT tokens.
 class FsmCollection
 {
 public:
+    static constexpr std::size_t MIN_CHUNK_SIZE = Lexer::MIN_CHUNK_SIZE;
+
+    FsmCollection() = default;
+
+    // Collection, which uses precompiled automaton, FSMs can not be attached to it
+    explicit FsmCollection(LexerAutomaton automaton)
+        : automaton_(std::move(automaton))
+    {
+    }
+
     // Appends new fsm to collection
     // Returns reference on this collection (so you can perform "collection.appendFsm(std::move(...)).appendFsm(...).appendFsm(...)...")
     // Be careful: function takes object only with rvalue reference. If you build some fsm in code, you can move it to this function.
     FsmCollection &appendFsm(std::unique_ptr<FiniteStateMachine> &&machine)
     {
+        if (collection_.empty() && isCompiled())
+        {
+            throw std::logic_error("FSM can not be attached to collection with precompiled automaton");
+        }
         collection_.emplace_back(std::move(machine));
-        currentFsmId_ = 0;
+        automaton_ = LexerAutomaton();
+        lexer_.reset();
         return *this;
     }
 
@@ -33,171 +62,108 @@ public:
         return appendFsm(std::make_unique<Fsm>(std::forward<FsmArgs>(args)...));
     }
 
-    // Tokenizes given text into fsm tokens. Changes reservedKeyword categories to given ones.
-    // Returns vector of tokens
-    std::vector<std::unique_ptr<token::Token>> tokenizeText(const std::string &text,
-                                                            const std::vector<std::pair<std::string, token::tokenCategory_t>> &reservedKeywords)
+    // Sets reserved keywords
+    // NAME tokens, which are keywords, get category of keyword instead
+    // Returns reference on this collection
+    FsmCollection &setKeywords(const KeywordTable &keywords)
     {
-        if (text.empty())
-        {
-            return {};
-        }
-        std::vector<std::unique_ptr<token::Token>> tokens;
-        auto processChar = [&](char c) {
-            pushNextChar(c, tokens);
-        };
-        std::for_each(text.begin(), text.end(), processChar);
-        processChar('\0');
-        for (const auto &token : tokens)
-        {
-            for (const auto &[keyword, category] : reservedKeywords)
-            {
-                if (token->getTokenString() == keyword)
-                {
-                    token->setCategory(category);
-                }
-            }
-        }
-        return tokens;
+        keywords_ = keywords;
+        lexer_.reset();
+        return *this;
     }
 
-    // Resets information about inputted text
-    void reset()
+    // Sets table, which NAME tokens are interned into, nullptr disables interning
+    // Returns reference on this collection
+    FsmCollection &setSymbolTable(std::shared_ptr<token::SymbolTable> symbols)
     {
-        resetFsmId();
-        currentToken_ = "";
-        currentTokenLineBeginPos_ = 0;
-        currentTokenTextBeginPos_ = 0;
-        currentTokenLine_ = 0;
+        symbols_ = std::move(symbols);
+        return *this;
     }
 
-private:
-    // Increases number of current FSM, drops to 0, if there is no more FSMs in collection.
-    // Returns if number has been increased.
-    bool setNextFsm() noexcept
+    std::shared_ptr<token::SymbolTable> getSymbolTable() const noexcept
     {
-        if (++currentFsmId_ == static_cast<int>(collection_.size()))
-        {
-            currentFsmId_ = 0;
-            return false;
-        }
-        else
-        {
-            return true;
-        }
+        return symbols_;
     }
 
-    void resetFsmId() noexcept
+    // Sets sequence of token categories, which makes single indentation level, empty one disables tracking
+    // Lexer emits INDENT and DEDENT tokens, when depth of line changes, see Lexer.
+    // Returns reference on this collection
+    FsmCollection &setIndentation(std::vector<token::tokenCategory_t> singleIndentationBlock)
     {
-        currentFsmId_ = 0;
+        indentationBlock_ = std::move(singleIndentationBlock);
+        lexer_.reset();
+        return *this;
     }
 
-    std::unique_ptr<FiniteStateMachine> &getCurrentFsm()
+    // Tokenizes given text into fsm tokens. Reserved keywords get their categories, names are interned.
+    // Tokens do not copy text, they refer to it, so text must outlive them.
+    // Returns buffer of tokens
+    token::TokenBuffer tokenizeText(std::string_view text)
     {
-        if (currentFsmId_ < 0)
-        {
-            throw std::out_of_range("collection must have at least one FSM to apply this operation");
-        }
-        return collection_.at(currentFsmId_);
+        return getLexer()->tokenize(text, symbols_.get());
     }
 
-    // Pushes next char in text to FSMs collection.
-    // Adds unique pointer to tokens, if terminal has been reached.
-    void pushNextChar(char c, std::vector<std::unique_ptr<token::Token>> &tokens)
+    // Tokenizes given text the same way, but chunks of lines are lexed by pool workers
+    // Tokens and symbol ids are identical to tokenizeText(text) ones, see Lexer::tokenize.
+    token::TokenBuffer tokenizeText(std::string_view text, tools::ThreadPool &pool, std::size_t minChunkSize = MIN_CHUNK_SIZE)
     {
-        auto addToken = [&](std::unique_ptr<token::Token> &&tk) {
-            if (!tk->getTokenString().empty() && tk->getTokenString()[0] != '\0')
-            {
-                tokens.emplace_back(std::move(tk));
-            }
-        };
+        return getLexer()->tokenize(text, pool, symbols_.get(), minChunkSize);
+    }
 
-        if (auto [successPush, prevNodeCategory] = pushCharRecursively(c); !successPush)
+    // Returns immutable lexer of collection, it is built on the first call after collection is changed
+    // Lexer can be shared by threads, which tokenize concurrently, while collection can not
+    std::shared_ptr<const Lexer> getLexer()
+    {
+        if (!lexer_)
         {
-            currentToken_ += c;
-            if (auto tk = buildAndMoveCurrentToken(prevNodeCategory))
+            if (!isCompiled())
             {
-                if (!tk->getTokenString().empty() && tk->getTokenString()[0] != '\0')
-                {
-                    addToken(std::move(tk));
-                }
+                compile();
             }
-            return;
+            lexer_ = std::make_shared<const Lexer>(automaton_, keywords_, indentationBlock_);
         }
-        else if (prevNodeCategory != token::tokenCategory::UNDEFINED)
-        {
-            addToken(buildAndMoveCurrentToken(prevNodeCategory));
-            pushNextChar(c, tokens);
-            return;
-        }
-        currentToken_ += c;
+        return lexer_;
     }
 
-    // Builds new token from currentToken_ currentTokenBeginPos_ and current node category
-    // Returns unique pointer on new token
-    std::unique_ptr<token::Token> buildAndMoveCurrentToken(token::tokenCategory_t category)
+    // Lowers attached FSMs into minimized product automaton
+    // Is called by tokenizeText automatically, if some FSM has been attached after last compilation
+    void compile()
     {
-        auto tokenLineBeginPos = currentTokenLineBeginPos_;
-        auto tokenTextBeginPos = currentTokenTextBeginPos_;
-        currentTokenTextBeginPos_ += currentToken_.length();
-        currentTokenLineBeginPos_ += currentToken_.length();
-        if (!currentToken_.empty() && token::isEndline(currentToken_[0]))
+        if (collection_.empty())
         {
-            currentTokenLineBeginPos_ = 0;
-            ++currentTokenLine_;
+            throw std::out_of_range("collection must have at least one FSM to apply this operation");
         }
-        auto result = std::make_unique<token::Token>(category,
-                                                     std::move(currentToken_),
-                                                     currentTokenLine_,
-                                                     tokenLineBeginPos,
-                                                     tokenTextBeginPos);
-        currentToken_.clear();
-        resetFsmId();
-        return result;
-    }
-
-    // Tries to fit current token in fsm collection in order of adding to collection
-    // Returns pair [if operation was successfull; previous node category]
-    std::pair<bool, token::tokenCategory_t> pushCharRecursively(char c)
-    {
-        if (auto [successfullPush, prevNodeCategory] = getCurrentFsm()->pushChar(c); !successfullPush)
+        std::vector<const FiniteStateMachine *> machines;
+        LiteralDecoders decoders;
+        for (const auto &machine : collection_)
         {
-            bool success = false;
-            while (!success)
+            machines.push_back(machine.get());
+            for (const auto &[category, decoder] : machine->getLiteralDecoders())
             {
-                if (!setNextFsm())
+                if (category < decoders.size() && decoders[category].empty())
                 {
-                    return {false, prevNodeCategory};
-                }
-                success = true;
-                for (char tokenC : currentToken_ + c)
-                {
-                    auto [curPushResult, curPrevNodeCategory] = getCurrentFsm()->pushChar(tokenC);
-                    if (!curPushResult)
-                    {
-                        success = false;
-                        break;
-                    }
-                    else
-                    {
-                        prevNodeCategory = curPrevNodeCategory;
-                    }
+                    decoders[category] = decoder; // machine, attached earlier, has priority
                 }
             }
-            return {true, prevNodeCategory};
-        }
-        else
-        {
-            return {true, prevNodeCategory};
         }
+        auto [byteClasses, compiled] = compileMachines(machines);
+        automaton_ = LexerAutomaton(compiled, byteClasses, decoders);
+        lexer_.reset();
     }
 
+    // Returns if attached FSMs are lowered into automaton
+    bool isCompiled() const noexcept
+    {
+        return !automaton_.empty();
+    }
+
+private:
     std::vector<std::unique_ptr<FiniteStateMachine>> collection_; // FSM collection
-    int currentFsmId_ = -1;                                       // current fsm id in vector
-    std::string currentToken_ = "";                               // current token string
-    std::size_t currentTokenLineBeginPos_ = 0;                    // current token begin position in line
-    std::size_t currentTokenTextBeginPos_ = 0;                    // current token begin position in text
-    std::size_t currentTokenLine_ = 0;                            // current token line number
+    LexerAutomaton automaton_;                                    // FSMs lowered into product automaton
+    KeywordTable keywords_;                                       // reserved keywords
+    std::shared_ptr<token::SymbolTable> symbols_;                 // table of interned names, may be null
+    std::vector<token::tokenCategory_t> indentationBlock_;        // single indentation level, may be empty
+    std::shared_ptr<const Lexer> lexer_;                          // lexer, built from fields above
 };
 } // namespace fsm
 } // namespace peach
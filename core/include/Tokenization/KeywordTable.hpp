@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "Token.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Perfect hash table of reserved keywords
+// Table is built at compile time, if it is declared constexpr: seed is searched, until no two keywords share a slot.
+// So lookup is one hash of three chars and one string comparison.
+class KeywordTable
+{
+public:
+    static constexpr std::size_t CAPACITY = 64;
+    static constexpr std::uint32_t MAX_SEED = 1 << 16;
+
+    struct Keyword
+    {
+        std::string_view word;
+        token::tokenCategory_t category = token::tokenCategory::UNDEFINED;
+    };
+
+    constexpr KeywordTable() = default;
+
+    // Builds table of keywords
+    // Throws if keywords are repeated or there are too many of them
+    template <std::size_t N>
+    constexpr KeywordTable(const Keyword (&keywords)[N])
+    {
+        static_assert(N <= CAPACITY, "too many keywords for KeywordTable");
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            if (keywords[i].word.empty())
+            {
+                throw std::invalid_argument("keyword can not be empty");
+            }
+            for (std::size_t j = 0; j < i; ++j)
+            {
+                if (keywords[i].word == keywords[j].word)
+                {
+                    throw std::invalid_argument("keyword is repeated");
+                }
+            }
+        }
+        for (; seed_ < MAX_SEED; ++seed_)
+        {
+            slots_ = {};
+            bool collided = false;
+            for (std::size_t i = 0; i < N && !collided; ++i)
+            {
+                Keyword &slot = slots_[hash(keywords[i].word, seed_)];
+                collided = !slot.word.empty();
+                slot = keywords[i];
+            }
+            if (!collided)
+            {
+                return;
+            }
+        }
+        throw std::length_error("keywords have no perfect hash");
+    }
+
+    // Returns category of word, if it is a keyword, given category otherwise
+    constexpr token::tokenCategory_t classify(std::string_view word, token::tokenCategory_t category) const noexcept
+    {
+        if (word.empty())
+        {
+            return category;
+        }
+        const Keyword &slot = slots_[hash(word, seed_)];
+        return slot.word == word ? slot.category : category;
+    }
+
+private:
+    // Mixes length, first, middle and last chars of non-empty word
+    static constexpr std::size_t hash(std::string_view word, std::uint32_t seed) noexcept
+    {
+        constexpr std::uint32_t FNV_PRIME = 16777619u;
+        std::uint32_t h = seed ^ static_cast<std::uint32_t>(word.size());
+        h = (h ^ static_cast<unsigned char>(word.front())) * FNV_PRIME;
+        h = (h ^ static_cast<unsigned char>(word[word.size() / 2])) * FNV_PRIME;
+        h = (h ^ static_cast<unsigned char>(word.back())) * FNV_PRIME;
+        return (h ^ (h >> 16)) % CAPACITY;
+    }
+
+    std::array<Keyword, CAPACITY> slots_{}; // keywords, placed by their hash
+    std::uint32_t seed_ = 0;                // seed, which places keywords without collisions
+};
+} // namespace fsm
+} // namespace peach
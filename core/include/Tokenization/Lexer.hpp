@@ -0,0 +1,417 @@
+#pragma once
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "KeywordTable.hpp"
+#include "LexerAutomaton.hpp"
+#include "SymbolTable.hpp"
+#include "ThreadPool.hpp"
+#include "TokenBuffer.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Lexer, which runs product automaton over text
+// Lexer is immutable: automaton tables, keywords and indentation block are fixed at construction,
+// position of every tokenization is kept in its own cursor. So one lexer can be shared by many threads,
+// which tokenize concurrently. Symbol table is mutated, so concurrent calls must not share it.
+// Every char is pushed at most twice, so tokenization is linear in text length.
+// If lexer has indentation block, it tracks indentation depth and emits INDENT and DEDENT tokens:
+// it counts complete blocks at the beginning of every line and right before the first token after them
+// emits empty INDENT or DEDENT token for every level, depth differs from depth of previous line by.
+// Line without tokens after indentation does not change depth. Depth of text is 0 before its first line.
+// If line has incomplete block or block token is out of place, INDENT_ERROR is emitted and depth is kept.
+class Lexer
+{
+public:
+    static constexpr std::size_t MIN_CHUNK_SIZE = 1 << 20;
+    static constexpr std::size_t CHUNKS_PER_THREAD = 4;
+    static constexpr std::size_t EXPECTED_TOKEN_LENGTH = 3; // buffers are reserved for text size / EXPECTED_TOKEN_LENGTH tokens
+
+    explicit Lexer(LexerAutomaton automaton,
+                   KeywordTable keywords = {},
+                   std::vector<token::tokenCategory_t> singleIndentationBlock = {})
+        : automaton_(std::move(automaton)),
+          keywords_(keywords),
+          indentationBlock_(std::move(singleIndentationBlock))
+    {
+        if (automaton_.empty())
+        {
+            throw std::invalid_argument("lexer can not be built from empty automaton");
+        }
+    }
+
+    // Tokenizes given text into tokens. Reserved keywords get their categories.
+    // Names are interned into symbols, unless it is nullptr.
+    // Tokens do not copy text, they refer to it, so text must outlive them.
+    // Returns buffer of tokens
+    token::TokenBuffer tokenize(std::string_view text, token::SymbolTable *symbols = nullptr) const
+    {
+        token::TokenBuffer tokens(text);
+        if (text.empty())
+        {
+            return tokens;
+        }
+        tokens.reserve(text.size() / EXPECTED_TOKEN_LENGTH);
+        Cursor cursor;
+        lexRange(tokens, 0, text.size(), cursor, symbols);
+        return tokens;
+    }
+
+    // Tokenizes single line, which is text of tokens buffer, it must not contain line ends
+    // Tokens are appended to buffer. Indentation tokens are emitted relative to depth of previous line,
+    // line updates it, so lines, lexed one by one, get the same tokens as their text without endlines.
+    // Returns id of the first undefined token of line, NONE if line does not have them
+    std::size_t tokenizeLine(token::TokenBuffer &tokens, std::size_t &depth, token::SymbolTable *symbols = nullptr) const
+    {
+        std::string_view line = tokens.getText();
+        if (line.find('\n') != std::string_view::npos)
+        {
+            throw std::invalid_argument("line can not contain line end");
+        }
+        Cursor cursor;
+        cursor.line.depth = depth;
+        lexRange(tokens, 0, line.size(), cursor, symbols);
+        depth = cursor.line.depth;
+        return cursor.firstUndefined;
+    }
+
+    // Tokenizes given text the same way, but chunks of text are lexed by pool workers
+    // Text is split after line ends into chunks of at least minChunkSize chars.
+    // Every chunk is lexed speculatively from root state at the beginning of line. If previous chunk does not end
+    // on token boundary (e.g. string literal contains line end) or its last line end is a part of undefined token,
+    // speculation is dropped and chunk is lexed again after previous one.
+    // Names are interned after chunks are stitched, in text order. Speculative chunk starts from depth 0,
+    // so indentation tokens of its first line are emitted again from depth of previous chunk.
+    // So tokens and symbol ids are always identical to tokenize(text, symbols) ones.
+    token::TokenBuffer tokenize(std::string_view text,
+                                tools::ThreadPool &pool,
+                                token::SymbolTable *symbols = nullptr,
+                                std::size_t minChunkSize = MIN_CHUNK_SIZE) const
+    {
+        token::TokenBuffer tokens(text);
+        if (text.empty())
+        {
+            return tokens;
+        }
+        std::vector<std::size_t> bounds = splitLines(text, pool.size() * CHUNKS_PER_THREAD, minChunkSize);
+        std::vector<std::future<Chunk>> speculations;
+        for (std::size_t id = 0; id + 1 < bounds.size(); ++id)
+        {
+            speculations.push_back(pool.submit([this, text, begin = bounds[id], end = bounds[id + 1]]() {
+                Chunk chunk{token::TokenBuffer(text), Cursor{0, begin, {}}};
+                chunk.tokens.reserve((end - begin) / EXPECTED_TOKEN_LENGTH);
+                lexRange(chunk.tokens, begin, end, chunk.cursor, nullptr);
+                return chunk;
+            }));
+        }
+        try
+        {
+            Cursor cursor;
+            for (std::size_t id = 0; id + 1 < bounds.size(); ++id)
+            {
+                Chunk chunk = speculations[id].get();
+                bool speculative = cursor.state == 0 && cursor.tokenBegin == bounds[id] &&
+                                   cursor.line.atBegin && cursor.line.blockPos == 0 && cursor.line.blocks == 0;
+                if (!speculative)
+                {
+                    chunk = Chunk{token::TokenBuffer(text), cursor};
+                    lexRange(chunk.tokens, bounds[id], bounds[id + 1], chunk.cursor, nullptr);
+                }
+                std::size_t depth = cursor.line.depth;
+                cursor = chunk.cursor;
+                if (bounds[id + 1] != text.size())
+                {
+                    finishToken(chunk.tokens, bounds[id + 1], cursor, nullptr);
+                }
+                std::size_t first = tokens.size();
+                tokens.append(chunk.tokens);
+                if (speculative)
+                {
+                    cursor.line.depth = rebaseIndentation(tokens, first, cursor.line, depth);
+                }
+                internNames(tokens, first, symbols);
+            }
+        }
+        catch (...)
+        {
+            // Workers refer to this lexer and text, they must finish before leaving
+            for (auto &speculation : speculations)
+            {
+                if (speculation.valid())
+                {
+                    speculation.wait();
+                }
+            }
+            throw;
+        }
+        return tokens;
+    }
+
+    const LexerAutomaton &getAutomaton() const noexcept
+    {
+        return automaton_;
+    }
+
+    const KeywordTable &getKeywords() const noexcept
+    {
+        return keywords_;
+    }
+
+    const std::vector<token::tokenCategory_t> &getIndentationBlock() const noexcept
+    {
+        return indentationBlock_;
+    }
+
+    static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+private:
+
+    // Indentation of line, which is being lexed
+    struct LineIndentation
+    {
+        bool atBegin = true;            // if only indentation tokens are lexed in line so far
+        std::size_t blockPos = 0;       // tokens of incomplete block
+        std::size_t blocks = 0;         // complete blocks
+        std::size_t depth = 0;          // depth of the last line with tokens after indentation
+        std::size_t firstMarker = NONE; // id of the first token after indentation of the first such line
+        std::size_t firstDepth = 0;     // depth of that line
+    };
+
+    // Position of lexer in text: state of automaton, begin of current token and indentation of line
+    struct Cursor
+    {
+        state_t state = 0;
+        std::size_t tokenBegin = 0;
+        LineIndentation line;
+        std::size_t firstUndefined = NONE; // id of the first undefined token
+    };
+
+    // Tokens of text chunk and position of lexer after it
+    struct Chunk
+    {
+        token::TokenBuffer tokens;
+        Cursor cursor;
+    };
+
+    // Lexes text[begin, end) from cursor, moves cursor to end
+    // If end is the end of text, text is followed by '\0', which finishes last token
+    // Names are interned into symbols, unless it is nullptr
+    void lexRange(token::TokenBuffer &tokens, std::size_t begin, std::size_t end, Cursor &cursor, token::SymbolTable *symbols) const
+    {
+        std::string_view text = tokens.getText();
+        std::size_t last = end == text.size() ? end : end - 1;
+        for (std::size_t pos = begin; pos <= last; ++pos)
+        {
+            char c = pos < text.size() ? text[pos] : '\0';
+            state_t cell = automaton_.getNext(cursor.state, c);
+            if (table::isAccept(cell))
+            {
+                addToken(tokens, cursor, table::getAcceptCategory(cell), table::getAcceptOperator(cell), cursor.tokenBegin, pos - cursor.tokenBegin, symbols);
+                cursor.tokenBegin = pos;
+                cell = automaton_.getNext(0, c); // root never accepts, so char is pushed at most twice
+            }
+            if (cell == table::REJECT)
+            {
+                addToken(tokens, cursor, token::tokenCategory::UNDEFINED, token::NO_OPERATOR, cursor.tokenBegin, std::min(pos + 1, text.size()) - cursor.tokenBegin, symbols); // trailing '\0' is not a part of text
+                if (cursor.firstUndefined == NONE && !tokens.empty() && tokens.getCategory(tokens.size() - 1) == token::tokenCategory::UNDEFINED)
+                {
+                    cursor.firstUndefined = tokens.size() - 1;
+                }
+                cursor.tokenBegin = pos + 1;
+                cursor.state = 0;
+                continue;
+            }
+            cursor.state = cell;
+
+            // Runs of identifier chars, digits or separators are scanned in bulk instead of char by char
+            const auto &runs = automaton_.getRuns(cursor.state);
+            const char *next = text.data() + std::min(pos + 1, end);
+            if (!runs.loop.empty())
+            {
+                pos += runs.loop.findRunLength(next, text.data() + end);
+            }
+            else if (!runs.repeat.empty())
+            {
+                std::size_t repeats = runs.repeat.findRunLength(next, text.data() + end);
+                for (std::size_t repeat = 0; repeat < repeats; ++repeat)
+                {
+                    addToken(tokens, cursor, table::getAcceptCategory(runs.repeatCell), table::getAcceptOperator(runs.repeatCell), cursor.tokenBegin, pos + repeat + 1 - cursor.tokenBegin, symbols);
+                    cursor.tokenBegin = pos + repeat + 1;
+                }
+                pos += repeats;
+            }
+        }
+    }
+
+    // Emits current token, if char at pos finishes it, so cursor gets to root state at pos
+    void finishToken(token::TokenBuffer &tokens, std::size_t pos, Cursor &cursor, token::SymbolTable *symbols) const
+    {
+        state_t cell = automaton_.getNext(cursor.state, tokens.getText()[pos]);
+        if (cursor.state != 0 && table::isAccept(cell))
+        {
+            addToken(tokens, cursor, table::getAcceptCategory(cell), table::getAcceptOperator(cell), cursor.tokenBegin, pos - cursor.tokenBegin, symbols);
+            cursor.state = 0;
+            cursor.tokenBegin = pos;
+        }
+    }
+
+    // Interns names of tokens, starting from first, into symbols, unless it is nullptr
+    static void internNames(token::TokenBuffer &tokens, std::size_t first, token::SymbolTable *symbols)
+    {
+        if (!symbols)
+        {
+            return;
+        }
+        for (std::size_t id = first; id < tokens.size(); ++id)
+        {
+            if (tokens.getCategory(id) == token::tokenCategory::NAME)
+            {
+                tokens.setSymbol(id, symbols->intern(tokens.getTokenString(id)));
+            }
+        }
+    }
+
+    // Returns begins of chunks, followed by text size
+    // Chunks begin after line ends, there are at most chunksCount of them
+    static std::vector<std::size_t> splitLines(std::string_view text, std::size_t chunksCount, std::size_t minChunkSize)
+    {
+        std::size_t chunkSize = std::max({text.size() / std::max<std::size_t>(chunksCount, 1), minChunkSize, std::size_t(1)});
+        std::vector<std::size_t> bounds = {0};
+        for (std::size_t pos = chunkSize; pos < text.size();)
+        {
+            std::size_t endline = text.find('\n', pos);
+            if (endline == std::string_view::npos || endline + 1 == text.size())
+            {
+                break;
+            }
+            bounds.push_back(endline + 1);
+            pos = endline + 1 + chunkSize;
+        }
+        bounds.push_back(text.size());
+        return bounds;
+    }
+
+    // Rebases indentation tokens of the first line of speculative chunk, which begins at token first, on depth
+    // Returns depth after chunk
+    static std::size_t rebaseIndentation(token::TokenBuffer &tokens, std::size_t first, const LineIndentation &line, std::size_t depth)
+    {
+        if (line.firstMarker == NONE)
+        {
+            return depth; // chunk does not change depth
+        }
+        std::size_t marker = first + line.firstMarker;
+        std::size_t offset = tokens.getTextPosition(marker);
+        tokens.erase(marker, marker + line.firstDepth); // chunk was lexed from depth 0
+        for (; depth < line.firstDepth; ++depth)
+        {
+            tokens.insert(marker, token::tokenCategory::INDENT, offset, 0);
+        }
+        for (; depth > line.firstDepth; --depth)
+        {
+            tokens.insert(marker, token::tokenCategory::DEDENT, offset, 0);
+        }
+        return line.depth;
+    }
+
+    // Counts indentation blocks at the beginning of line, is called for tokens at the beginning of line and endlines
+    // Emits indentation tokens before token of category at offset, if it is the first one after indentation
+    void trackIndentation(token::TokenBuffer &tokens, LineIndentation &line, token::tokenCategory_t category, std::size_t offset) const
+    {
+        if (token::isEndline(category))
+        {
+            line.atBegin = true;
+            line.blockPos = 0;
+            line.blocks = 0;
+            return;
+        }
+        if (category == indentationBlock_[line.blockPos])
+        {
+            if (++line.blockPos == indentationBlock_.size())
+            {
+                line.blockPos = 0;
+                ++line.blocks;
+            }
+            return;
+        }
+        line.atBegin = false;
+        if (line.blockPos != 0 ||
+            std::find(indentationBlock_.begin(), indentationBlock_.end(), category) != indentationBlock_.end())
+        {
+            tokens.push(token::tokenCategory::INDENT_ERROR, offset, 0);
+            return;
+        }
+        if (line.firstMarker == NONE)
+        {
+            line.firstMarker = tokens.size();
+            line.firstDepth = line.blocks;
+        }
+        for (; line.depth < line.blocks; ++line.depth)
+        {
+            tokens.push(token::tokenCategory::INDENT, offset, 0);
+        }
+        for (; line.depth > line.blocks; --line.depth)
+        {
+            tokens.push(token::tokenCategory::DEDENT, offset, 0);
+        }
+    }
+
+    // Adds token to tokens, if it is not empty
+    // Name tokens are classified as keywords and interned into symbols, literals are decoded here,
+    // operator tokens keep id of their operator
+    // Indentation tokens are emitted before token, if it is the first one after indentation
+    void addToken(token::TokenBuffer &tokens,
+                  Cursor &cursor,
+                  token::tokenCategory_t category,
+                  std::size_t operatorId,
+                  std::size_t offset,
+                  std::size_t length,
+                  token::SymbolTable *symbols) const
+    {
+        if (length == 0)
+        {
+            return;
+        }
+        std::string_view name;
+        if (category == token::tokenCategory::NAME)
+        {
+            name = tokens.getText().substr(offset, length);
+            category = keywords_.classify(name, category);
+        }
+        if (!indentationBlock_.empty() && (cursor.line.atBegin || token::isEndline(category)))
+        {
+            trackIndentation(tokens, cursor.line, category, offset);
+        }
+        if (symbols && category == token::tokenCategory::NAME)
+        {
+            tokens.pushSymbol(category, offset, length, symbols->intern(name));
+            return;
+        }
+        if (operatorId != token::NO_OPERATOR)
+        {
+            tokens.pushOperator(category, offset, length, operatorId);
+            return;
+        }
+        auto decoder = automaton_.getDecoder(category);
+        if (decoder.empty())
+        {
+            tokens.push(category, offset, length);
+        }
+        else
+        {
+            tokens.pushLiteral(category, offset, length, decoder.decode(tokens.getText().substr(offset, length)));
+        }
+    }
+
+    LexerAutomaton automaton_;                             // product automaton of token machines
+    KeywordTable keywords_;                                // reserved keywords
+    std::vector<token::tokenCategory_t> indentationBlock_; // single indentation level, may be empty
+};
+} // namespace fsm
+} // namespace peach
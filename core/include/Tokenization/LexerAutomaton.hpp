@@ -0,0 +1,209 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "ByteScanner.hpp"
+#include "CompiledFsm.hpp"
+#include "Literal.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Runs of chars, which can be processed in bulk in some state of automaton
+struct StateRuns
+{
+    // Chars, which keep automaton in this state: token continues
+    ByteRangeSet loop;
+
+    // Chars, which finish current token with repeatCell and start new single char token in this state
+    ByteRangeSet repeat;
+    state_t repeatCell = table::REJECT;
+};
+
+// Finds runs of state of automaton, getNext(state, char) returns cell of automaton
+template <typename GetNext>
+constexpr StateRuns findStateRuns(state_t state, GetNext getNext)
+{
+    StateRuns runs;
+    if (state == 0)
+    {
+        return runs;
+    }
+    transition::CharSet loop, repeat;
+    for (int byte = 0; byte < static_cast<int>(table::BYTES_TOTAL); ++byte)
+    {
+        char c = static_cast<char>(byte);
+        state_t cell = getNext(state, c);
+        if (cell == state)
+        {
+            loop.insert(c);
+        }
+        if (table::isAccept(cell) && getNext(0, c) == state)
+        {
+            if (runs.repeatCell == table::REJECT)
+            {
+                runs.repeatCell = cell;
+            }
+            if (cell == runs.repeatCell)
+            {
+                repeat.insert(c);
+            }
+        }
+    }
+    runs.loop = ByteRangeSet(loop);
+    runs.repeat = ByteRangeSet(repeat);
+    return runs;
+}
+
+// Literal decoder of each token category, which fits in byte
+using LiteralDecoders = std::array<token::LiteralDecoder, table::BYTES_TOTAL>;
+
+// Product of compiled machines, runs all of them in lockstep
+// Cell semantics:
+//     - state:           char is consumed, token continues
+//     - ACCEPT | category: token ended before char, it has given category, char must be pushed again from root
+//     - REJECT:          no machine accepts token with char, char is consumed, token has UNDEFINED category
+// Machine priority is preserved: the first alive machine in adding order decides, what happens with token
+// Automaton also knows, which categories are literals and how to decode them.
+// Automaton either owns tables, built at runtime, or refers to tables, built at compile time.
+// Copies share tables.
+class LexerAutomaton
+{
+public:
+    LexerAutomaton() = default;
+
+    // Builds product of machines, which share byteClasses
+    LexerAutomaton(const std::vector<CompiledFsm> &machines, const ByteClassMap &byteClasses, const LiteralDecoders &decoders = {})
+    {
+        using Tuple = std::vector<state_t>; // state of each machine, REJECT if machine is dead
+
+        std::size_t classCount = byteClasses.getClassCount();
+        std::map<Tuple, state_t> stateOf;
+        std::vector<Tuple> queue = {Tuple(machines.size(), 0)};
+        stateOf[queue.front()] = 0;
+        std::vector<state_t> cells;
+        for (std::size_t head = 0; head < queue.size(); ++head)
+        {
+            for (std::size_t cls = 0; cls < classCount; ++cls)
+            {
+                Tuple next = queue[head];
+                state_t cell = table::REJECT;
+                for (std::size_t id = 0; id < machines.size(); ++id)
+                {
+                    if (next[id] == table::REJECT)
+                    {
+                        continue;
+                    }
+                    state_t machineCell = machines[id].getNext(next[id], static_cast<std::uint8_t>(cls));
+                    next[id] = table::isState(machineCell) ? machineCell : (machineCell == table::REJECT ? table::REJECT : 0);
+                    if (cell == table::REJECT && machineCell != table::REJECT)
+                    {
+                        cell = machineCell; // first alive machine
+                    }
+                }
+                if (table::isState(cell))
+                {
+                    auto [it, inserted] = stateOf.emplace(next, static_cast<state_t>(queue.size()));
+                    if (inserted)
+                    {
+                        if (queue.size() >= table::MAX_STATES)
+                        {
+                            throw std::length_error("lexer automaton has too many states");
+                        }
+                        queue.push_back(std::move(next));
+                    }
+                    cell = it->second;
+                }
+                cells.push_back(cell);
+            }
+        }
+
+        auto storage = std::make_shared<Storage>();
+        storage->cells = details::minimize(cells, classCount);
+        storage->byteClasses = byteClasses;
+        storage->decoders = decoders;
+        refer(storage->cells.data(), storage->cells.size() / classCount, classCount, storage->byteClasses.getClasses().data(), nullptr, &storage->decoders);
+        for (state_t state = 0; state < stateCount_; ++state)
+        {
+            storage->runs.push_back(findStateRuns(state, [this](state_t from, char c) { return getNext(from, c); }));
+        }
+        runs_ = storage->runs.data();
+        storage_ = std::move(storage);
+    }
+
+    // Refers to tables, which must outlive automaton:
+    // cells[stateCount][classCount], class of each byte, runs of each state and decoder of each category
+    LexerAutomaton(const state_t *cells,
+                   std::size_t stateCount,
+                   std::size_t classCount,
+                   const std::uint8_t *classOf,
+                   const StateRuns *runs,
+                   const LiteralDecoders *decoders) noexcept
+    {
+        refer(cells, stateCount, classCount, classOf, runs, decoders);
+    }
+
+    state_t getNext(state_t state, char c) const noexcept
+    {
+        return table_[state * classCount_ + classOf_[static_cast<unsigned char>(c)]];
+    }
+
+    const StateRuns &getRuns(state_t state) const noexcept
+    {
+        return runs_[state];
+    }
+
+    // Returns decoder of tokens of category, empty one if they are not literals
+    token::LiteralDecoder getDecoder(token::tokenCategory_t category) const noexcept
+    {
+        return category < decoders_->size() ? (*decoders_)[category] : token::LiteralDecoder();
+    }
+
+    std::size_t getStateCount() const noexcept
+    {
+        return stateCount_;
+    }
+
+    bool empty() const noexcept
+    {
+        return stateCount_ == 0;
+    }
+
+private:
+    // Tables of automaton, built at runtime
+    struct Storage
+    {
+        std::vector<state_t> cells;
+        ByteClassMap byteClasses;
+        std::vector<StateRuns> runs;
+        LiteralDecoders decoders;
+    };
+
+    void refer(const state_t *cells,
+               std::size_t stateCount,
+               std::size_t classCount,
+               const std::uint8_t *classOf,
+               const StateRuns *runs,
+               const LiteralDecoders *decoders) noexcept
+    {
+        table_ = cells;
+        stateCount_ = stateCount;
+        classCount_ = classCount;
+        classOf_ = classOf;
+        runs_ = runs;
+        decoders_ = decoders;
+    }
+
+    const state_t *table_ = nullptr;            // next cell of each state and byte class
+    const std::uint8_t *classOf_ = nullptr;     // byte class of each byte
+    const StateRuns *runs_ = nullptr;           // runs of each state
+    const LiteralDecoders *decoders_ = nullptr; // decoder of each category
+    std::size_t stateCount_ = 0;
+    std::size_t classCount_ = 0;
+    std::shared_ptr<const Storage> storage_;    // owner of tables, if they were built at runtime
+};
+} // namespace fsm
+} // namespace peach
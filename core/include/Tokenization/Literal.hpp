@@ -0,0 +1,132 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <variant>
+
+namespace peach
+{
+namespace token
+{
+// Reason, why literal could not be decoded
+enum class LiteralError : std::uint8_t
+{
+    OUT_OF_RANGE,
+    INVALID,
+};
+
+// Decoded value of literal token
+using LiteralValue = std::variant<LiteralError, std::int64_t, double, std::string>;
+
+// Describes how tokens of some category are decoded while they are lexed
+// Decoder is a literal type, so it can be a part of tables, built at compile time
+struct LiteralDecoder
+{
+    enum class Kind : std::uint8_t
+    {
+        NONE,     // tokens are not literals
+        INTEGER,  // decimal integer with optional minus
+        FLOATING, // decimal number with separator
+        STRING,   // text between quotes, backslash escapes are unescaped
+    };
+
+    Kind kind = Kind::NONE;
+    char separator = '.'; // decimal separator of FLOATING, quote of STRING
+
+    static constexpr LiteralDecoder integer() noexcept { return {Kind::INTEGER, '.'}; }
+    static constexpr LiteralDecoder floating(char decimalSeparator) noexcept { return {Kind::FLOATING, decimalSeparator}; }
+    static constexpr LiteralDecoder string(char quote) noexcept { return {Kind::STRING, quote}; }
+
+    constexpr bool empty() const noexcept
+    {
+        return kind == Kind::NONE;
+    }
+
+    // Returns decoded value of token text
+    LiteralValue decode(std::string_view text) const
+    {
+        switch (kind)
+        {
+        case Kind::INTEGER:
+            return decodeNumber<std::int64_t>(text);
+        case Kind::FLOATING:
+            return decodeFloating(text);
+        case Kind::STRING:
+            return decodeString(text);
+        default:
+            return LiteralError::INVALID;
+        }
+    }
+
+private:
+    template <typename T>
+    static LiteralValue decodeNumber(std::string_view text)
+    {
+        T value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error == std::errc::result_out_of_range)
+        {
+            return LiteralError::OUT_OF_RANGE;
+        }
+        if (error != std::errc() || end != text.data() + text.size())
+        {
+            return LiteralError::INVALID;
+        }
+        return value;
+    }
+
+    // from_chars expects '.', so other separators are replaced in a copy
+    LiteralValue decodeFloating(std::string_view text) const
+    {
+        if (separator == '.')
+        {
+            return decodeNumber<double>(text);
+        }
+        std::string copy(text);
+        for (char &c : copy)
+        {
+            c = c == separator ? '.' : c;
+        }
+        return decodeNumber<double>(copy);
+    }
+
+    LiteralValue decodeString(std::string_view text) const
+    {
+        if (text.size() < 2 || text.front() != separator || text.back() != separator)
+        {
+            return LiteralError::INVALID;
+        }
+        text = text.substr(1, text.size() - 2);
+        std::string value;
+        value.reserve(text.size());
+        for (std::size_t pos = 0; pos < text.size(); ++pos)
+        {
+            if (text[pos] != '\\' || pos + 1 == text.size())
+            {
+                value.push_back(text[pos]);
+                continue;
+            }
+            switch (text[++pos])
+            {
+            case 'n':
+                value.push_back('\n');
+                break;
+            case 't':
+                value.push_back('\t');
+                break;
+            case '0':
+                value.push_back('\0');
+                break;
+            default:
+                value.push_back(text[pos]);
+                break;
+            }
+        }
+        return value;
+    }
+};
+} // namespace token
+} // namespace peach
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+
+#include "Literal.hpp"
+#include "Token.hpp"
+#include "Transition.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Graph of finite state machine, which can be built at compile time
+// Nodes are numbered in adding order, root is node 0
+// Like in Node, transitions of node are checked in adding order, the first active one is followed
+template <std::size_t MaxNodes>
+class StaticFsm
+{
+public:
+    static constexpr std::size_t CAPACITY = MaxNodes;
+    static constexpr std::size_t NONE = MaxNodes;
+
+    constexpr StaticFsm()
+    {
+        addNode(token::tokenCategory::UNDEFINED);
+    }
+
+    // Returns index of new node
+    constexpr std::size_t addNode(token::tokenCategory_t category)
+    {
+        if (nodeCount_ == MaxNodes)
+        {
+            throw std::length_error("too many nodes in static finite state machine");
+        }
+        categories_[nodeCount_] = category;
+        operatorIds_[nodeCount_] = token::NO_OPERATOR;
+        return nodeCount_++;
+    }
+
+    // Adds transition from node to node, which is active on chars
+    constexpr void addTransition(std::size_t from, const transition::CharSet &chars, std::size_t to)
+    {
+        if (from >= nodeCount_ || to >= nodeCount_)
+        {
+            throw std::out_of_range("node does not exist");
+        }
+        if (edgeCount_ == edges_.size())
+        {
+            throw std::length_error("too many transitions in static finite state machine");
+        }
+        edges_[edgeCount_++] = Edge{from, to, chars};
+    }
+
+    // Adds transition of class Transition, it must have static constexpr contains(char)
+    template <typename Transition>
+    constexpr void addTransition(std::size_t from, std::size_t to)
+    {
+        addTransition(from, transition::CharSet::of<Transition>(), to);
+    }
+
+    // Adds transition from node to new node with category
+    // Returns index of new node
+    template <typename Transition>
+    constexpr std::size_t addTransitionToNewNode(std::size_t from, token::tokenCategory_t category)
+    {
+        std::size_t to = addNode(category);
+        addTransition<Transition>(from, to);
+        return to;
+    }
+
+    // Returns index of node, c leads from node to, NONE if there is no such transition
+    constexpr std::size_t getNextNode(std::size_t node, char c) const noexcept
+    {
+        for (std::size_t edge = 0; edge < edgeCount_; ++edge)
+        {
+            if (edges_[edge].from == node && edges_[edge].chars.contains(c))
+            {
+                return edges_[edge].to;
+            }
+        }
+        return NONE;
+    }
+
+    // Tokens of terminal node get operator id
+    constexpr void setOperatorId(std::size_t node, std::size_t operatorId)
+    {
+        if (node >= nodeCount_)
+        {
+            throw std::out_of_range("node does not exist");
+        }
+        operatorIds_[node] = operatorId;
+    }
+
+    // Tokens of category will be decoded with decoder, when they are lexed
+    constexpr void setLiteralDecoder(token::tokenCategory_t category, token::LiteralDecoder decoder) noexcept
+    {
+        literalCategory_ = category;
+        literalDecoder_ = decoder;
+    }
+
+    constexpr token::tokenCategory_t getLiteralCategory() const noexcept { return literalCategory_; }
+    constexpr token::LiteralDecoder getLiteralDecoder() const noexcept { return literalDecoder_; }
+
+    constexpr std::size_t getNodeCount() const noexcept { return nodeCount_; }
+    constexpr std::size_t getEdgeCount() const noexcept { return edgeCount_; }
+    constexpr bool isTerminal(std::size_t node) const noexcept { return categories_[node] != token::tokenCategory::UNDEFINED; }
+    constexpr token::tokenCategory_t getCategory(std::size_t node) const noexcept { return categories_[node]; }
+    constexpr std::size_t getOperatorId(std::size_t node) const noexcept { return operatorIds_[node]; }
+
+    // Edges are numbered in adding order
+    constexpr std::size_t getEdgeFrom(std::size_t edge) const noexcept { return edges_[edge].from; }
+    constexpr std::size_t getEdgeTo(std::size_t edge) const noexcept { return edges_[edge].to; }
+    constexpr const transition::CharSet &getEdgeChars(std::size_t edge) const noexcept { return edges_[edge].chars; }
+
+private:
+    struct Edge
+    {
+        std::size_t from = 0;
+        std::size_t to = 0;
+        transition::CharSet chars;
+    };
+
+    std::array<token::tokenCategory_t, MaxNodes> categories_{}; // category of each node
+    std::array<std::size_t, MaxNodes> operatorIds_{};          // operator id of each node
+    std::size_t nodeCount_ = 0;
+    std::array<Edge, 2 * MaxNodes> edges_{}; // transitions in adding order
+    std::size_t edgeCount_ = 0;
+    token::tokenCategory_t literalCategory_ = token::tokenCategory::UNDEFINED; // category of decoded tokens
+    token::LiteralDecoder literalDecoder_;                                     // decoder of their values
+};
+} // namespace fsm
+} // namespace peach
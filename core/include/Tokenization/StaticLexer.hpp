@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+
+#include "CompiledFsm.hpp"
+#include "LexerAutomaton.hpp"
+#include "StaticFsm.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Lexer tables, built from StaticFsm graphs at compile time
+// Declared constexpr, they are placed into read-only memory and shared by all FsmCollections, which use them.
+// Semantics are the same as of LexerAutomaton, built from the same machines at runtime:
+// machines are run in lockstep and the first alive one decides.
+template <std::size_t MaxStates, std::size_t MaxClasses>
+class StaticLexerTables
+{
+public:
+    // Builds product of machines, they have priority in given order
+    // Throws, if tables do not fit in MaxStates states or MaxClasses byte classes
+    template <typename... Machines>
+    constexpr StaticLexerTables(const Machines &... machines)
+    {
+        constexpr std::size_t machineCount = sizeof...(Machines);
+        constexpr std::size_t totalNodes = (Machines::CAPACITY + ...);
+
+        // Dense table of every node of every machine over all bytes
+        std::array<state_t, totalNodes * table::BYTES_TOTAL> raw{};
+        std::array<std::size_t, machineCount + 1> firstRow{};
+        std::size_t machine = 0;
+        auto fill = [&](const auto &fsm) {
+            firstRow[machine + 1] = fillRawTable(fsm, raw, firstRow[machine]);
+            ++machine;
+            if (!fsm.getLiteralDecoder().empty() && fsm.getLiteralCategory() < decoders_.size() &&
+                decoders_[fsm.getLiteralCategory()].empty())
+            {
+                decoders_[fsm.getLiteralCategory()] = fsm.getLiteralDecoder();
+            }
+        };
+        (fill(machines), ...);
+        std::size_t rowCount = firstRow[machineCount];
+
+        // Bytes with equal columns share the class, classes are numbered in order of first byte occurence
+        std::array<std::size_t, MaxClasses> representative{};
+        for (std::size_t byte = 0; byte < table::BYTES_TOTAL; ++byte)
+        {
+            std::size_t cls = 0;
+            while (cls < classCount_ && !haveEqualColumns(raw, rowCount, representative[cls], byte))
+            {
+                ++cls;
+            }
+            if (cls == classCount_)
+            {
+                if (classCount_ == MaxClasses)
+                {
+                    throw std::length_error("too many byte classes in static lexer tables");
+                }
+                representative[classCount_++] = byte;
+            }
+            classOf_[byte] = static_cast<std::uint8_t>(cls);
+        }
+
+        // Product of machines: state of each machine, REJECT if machine is dead
+        std::array<std::array<state_t, machineCount>, MaxStates> tuples{};
+        stateCount_ = 1;
+        for (std::size_t head = 0; head < stateCount_; ++head)
+        {
+            for (std::size_t cls = 0; cls < classCount_; ++cls)
+            {
+                auto next = tuples[head];
+                state_t cell = table::REJECT;
+                for (std::size_t id = 0; id < machineCount; ++id)
+                {
+                    if (next[id] == table::REJECT)
+                    {
+                        continue;
+                    }
+                    state_t machineCell = raw[(firstRow[id] + next[id]) * table::BYTES_TOTAL + representative[cls]];
+                    next[id] = table::isState(machineCell) ? machineCell : (machineCell == table::REJECT ? table::REJECT : 0);
+                    if (cell == table::REJECT && machineCell != table::REJECT)
+                    {
+                        cell = machineCell; // first alive machine
+                    }
+                }
+                if (table::isState(cell))
+                {
+                    std::size_t state = 0;
+                    while (state < stateCount_ && !isSameTuple(tuples[state], next))
+                    {
+                        ++state;
+                    }
+                    if (state == stateCount_)
+                    {
+                        if (stateCount_ == MaxStates)
+                        {
+                            throw std::length_error("too many states in static lexer tables");
+                        }
+                        tuples[stateCount_++] = next;
+                    }
+                    cell = static_cast<state_t>(state);
+                }
+                cells_[head * MaxClasses + cls] = cell;
+            }
+        }
+
+        for (std::size_t state = 0; state < stateCount_; ++state)
+        {
+            runs_[state] = findStateRuns(static_cast<state_t>(state), [this](state_t from, char c) { return getNext(from, c); });
+        }
+    }
+
+    // Returns automaton, which refers to these tables, so they must outlive it
+    LexerAutomaton getAutomaton() const noexcept
+    {
+        return LexerAutomaton(cells_.data(), stateCount_, MaxClasses, classOf_.data(), runs_.data(), &decoders_);
+    }
+
+    constexpr state_t getNext(state_t state, char c) const noexcept
+    {
+        return cells_[state * MaxClasses + classOf_[static_cast<unsigned char>(c)]];
+    }
+
+    constexpr std::size_t getStateCount() const noexcept { return stateCount_; }
+    constexpr std::size_t getClassCount() const noexcept { return classCount_; }
+
+private:
+    // Writes rows of machine nodes to raw, starting from row begin
+    // Cells are node indices in machine, ACCEPT | category for terminals and REJECT
+    // Returns row after the last one
+    template <typename Machine, typename Raw>
+    static constexpr std::size_t fillRawTable(const Machine &machine, Raw &raw, std::size_t begin)
+    {
+        std::size_t end = begin + machine.getNodeCount();
+        for (std::size_t cell = begin * table::BYTES_TOTAL; cell < end * table::BYTES_TOTAL; ++cell)
+        {
+            raw[cell] = table::REJECT;
+        }
+        // Earlier transitions of node win, so they are written last
+        for (std::size_t edge = machine.getEdgeCount(); edge-- > 0;)
+        {
+            std::size_t from = machine.getEdgeFrom(edge);
+            std::size_t to = machine.getEdgeTo(edge);
+            state_t cell = static_cast<state_t>(to);
+            if (machine.isTerminal(to))
+            {
+                if (from == 0)
+                {
+                    throw std::invalid_argument("root node can not lead to terminal: empty tokens are not allowed");
+                }
+                if (machine.getCategory(to) > table::MAX_ACCEPT_CATEGORY)
+                {
+                    throw std::invalid_argument("token category is too large to be compiled");
+                }
+                cell = table::makeAccept(machine.getCategory(to), machine.getOperatorId(to));
+            }
+            for (std::size_t byte = 0; byte < table::BYTES_TOTAL; ++byte)
+            {
+                if (machine.getEdgeChars(edge).contains(static_cast<char>(byte)))
+                {
+                    raw[(begin + from) * table::BYTES_TOTAL + byte] = cell;
+                }
+            }
+        }
+        return end;
+    }
+
+    template <typename Raw>
+    static constexpr bool haveEqualColumns(const Raw &raw, std::size_t rowCount, std::size_t first, std::size_t second)
+    {
+        for (std::size_t row = 0; row < rowCount; ++row)
+        {
+            if (raw[row * table::BYTES_TOTAL + first] != raw[row * table::BYTES_TOTAL + second])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Tuple>
+    static constexpr bool isSameTuple(const Tuple &first, const Tuple &second)
+    {
+        for (std::size_t id = 0; id < first.size(); ++id)
+        {
+            if (first[id] != second[id])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::array<std::uint8_t, table::BYTES_TOTAL> classOf_{}; // byte class of each byte
+    std::array<state_t, MaxStates * MaxClasses> cells_{};    // next cell of each state and byte class
+    std::array<StateRuns, MaxStates> runs_{};                // runs of each state
+    LiteralDecoders decoders_{};                             // decoder of each category
+    std::size_t stateCount_ = 0;
+    std::size_t classCount_ = 0;
+};
+} // namespace fsm
+} // namespace peach
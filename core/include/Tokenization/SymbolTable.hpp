@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace peach
+{
+namespace token
+{
+// Id of interned identifier
+using symbol_t = std::uint32_t;
+
+// Interned identifiers of program
+// Every distinct name is stored once and gets dense id in order of first occurence,
+// so later stages compare and index names by id instead of hashing and copying strings.
+// Names are kept in single char arena, ids are found by open addressing hash table,
+// which stores hash of each name, so most probes do not touch the arena.
+// Table is not thread safe: names must be interned by one thread at a time.
+class SymbolTable
+{
+public:
+    static constexpr symbol_t NO_SYMBOL = std::numeric_limits<symbol_t>::max();
+    static constexpr std::size_t INITIAL_CAPACITY = 64;
+
+    // Returns id of name, name is added to table if it is new
+    symbol_t intern(std::string_view name)
+    {
+        std::size_t hash = std::hash<std::string_view>()(name);
+        std::size_t slot = findSlot(name, hash);
+        if (slots_[slot].symbol != NO_SYMBOL)
+        {
+            return slots_[slot].symbol;
+        }
+        if (nameBegins_.size() >= NO_SYMBOL - 1 || arena_.size() + name.size() > NO_SYMBOL)
+        {
+            throw std::length_error("too many symbols in symbol table");
+        }
+        auto symbol = static_cast<symbol_t>(size());
+        arena_.append(name);
+        nameBegins_.push_back(static_cast<std::uint32_t>(arena_.size()));
+        slots_[slot] = Slot{static_cast<std::uint32_t>(hash), symbol};
+        if (2 * size() > slots_.size())
+        {
+            rehash(2 * slots_.size());
+        }
+        return symbol;
+    }
+
+    // Returns id of name, NO_SYMBOL if name is not interned
+    symbol_t find(std::string_view name) const noexcept
+    {
+        return slots_.empty() ? NO_SYMBOL : slots_[findSlot(name, std::hash<std::string_view>()(name))].symbol;
+    }
+
+    // Returns name of symbol, it must be interned
+    // Name refers to table, it is invalidated by the next intern call
+    std::string_view getName(symbol_t symbol) const noexcept
+    {
+        return std::string_view(arena_).substr(nameBegins_[symbol], nameBegins_[symbol + 1] - nameBegins_[symbol]);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return nameBegins_.size() - 1;
+    }
+
+private:
+    struct Slot
+    {
+        std::uint32_t hash = 0;
+        symbol_t symbol = NO_SYMBOL;
+    };
+
+    // Returns slot of name, or empty slot, where it should be inserted
+    // Capacity is a power of two, slots are probed linearly
+    std::size_t findSlot(std::string_view name, std::size_t hash) const noexcept
+    {
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask)
+        {
+            const Slot &candidate = slots_[slot];
+            if (candidate.symbol == NO_SYMBOL ||
+                (candidate.hash == static_cast<std::uint32_t>(hash) && getName(candidate.symbol) == name))
+            {
+                return slot;
+            }
+        }
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        std::vector<Slot> slots(capacity);
+        std::size_t mask = capacity - 1;
+        for (const Slot &old : slots_)
+        {
+            if (old.symbol == NO_SYMBOL)
+            {
+                continue;
+            }
+            // Only low bits of hash are needed to place symbol, they are stored in slot
+            std::size_t slot = old.hash & mask;
+            while (slots[slot].symbol != NO_SYMBOL)
+            {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = old;
+        }
+        slots_ = std::move(slots);
+    }
+
+    std::string arena_;                           // names of all symbols one after another
+    std::vector<std::uint32_t> nameBegins_ = {0}; // begin of each name in arena, followed by arena size
+    std::vector<Slot> slots_ = std::vector<Slot>(INITIAL_CAPACITY); // hash table of symbols
+};
+} // namespace token
+} // namespace peach
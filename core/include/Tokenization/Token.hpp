@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -102,7 +103,17 @@ struct tokenCategory
         // Token is variable declaration
         DECLARATION = 19,
 
-        _TOKEN_TOTAL = 20;
+        // Token is an increase of indentation level by one
+        // It is empty and is emitted by lexer right before the first token of line after indentation
+        INDENT = 20,
+
+        // Token is a decrease of indentation level by one, it is emitted like INDENT
+        DEDENT = 21,
+
+        // Token is a broken indentation: incomplete or misplaced indentation block, it is emitted like INDENT
+        INDENT_ERROR = 22,
+
+        _TOKEN_TOTAL = 23;
 };
 
 static std::vector<std::string> tokenCategoryString = {
@@ -126,8 +137,14 @@ static std::vector<std::string> tokenCategoryString = {
     "COLON",
     "SEMICOLON",
     "DECLARATION",
+    "INDENT",
+    "DEDENT",
+    "INDENT_ERROR",
 };
 
+// Operator tokens may carry dense id of their operator, which is the index of its pattern in operator finder
+static constexpr std::size_t NO_OPERATOR = std::numeric_limits<std::size_t>::max();
+
 inline void registerTokenCategoryString(const std::string &name)
 {
     tokenCategoryString.push_back(name);
@@ -142,38 +159,6 @@ inline void printCategory(std::ostream &os, tokenCategory_t category)
     os << tokenCategoryString[static_cast<std::size_t>(category)];
 }
 
-class Token
-{
-public:
-    Token(tokenCategory_t category,
-          std::string token,
-          std::size_t line,
-          std::size_t linePosition,
-          std::size_t textPosition)
-        : category_(std::move(category)),
-          token_(std::move(token)),
-          line_(std::move(line)),
-          linePosition_(std::move(linePosition)),
-          textPosition_(std::move(textPosition))
-    {
-    }
-
-    tokenCategory_t getCategory() const noexcept { return category_; }
-    std::string getTokenString() const { return token_; }
-    std::size_t getLine() const noexcept { return line_; }
-    int getLinePosition() const noexcept { return linePosition_; }
-    int getTextPosition() const noexcept { return textPosition_; }
-
-    void setCategory(tokenCategory_t category) noexcept { category_ = category; }
-
-private:
-    tokenCategory_t category_;
-    std::string token_;
-    std::size_t line_, linePosition_, textPosition_;
-};
-
-using TokenPtr = std::unique_ptr<Token>;
-
 inline constexpr bool isEndline(tokenCategory_t category) noexcept
 {
     return category == tokenCategory::SEP_ENDL;
@@ -184,11 +169,6 @@ inline constexpr bool isEndline(char c) noexcept
     return c == '\n';
 }
 
-inline bool isEndline(const TokenPtr &tk) noexcept
-{
-    return isEndline(tk->getCategory());
-}
-
 inline constexpr bool isSeparator(tokenCategory_t category) noexcept
 {
     return category == tokenCategory::SEP_ENDL ||
@@ -196,9 +176,11 @@ inline constexpr bool isSeparator(tokenCategory_t category) noexcept
            category == tokenCategory::SEP_TAB;
 }
 
-inline bool isSeparator(const TokenPtr &tk) noexcept
+inline constexpr bool isIndentation(tokenCategory_t category) noexcept
 {
-    return isSeparator(tk->getCategory());
+    return category == tokenCategory::INDENT ||
+           category == tokenCategory::DEDENT ||
+           category == tokenCategory::INDENT_ERROR;
 }
 
 inline std::size_t getTokenOperatorArity(tokenCategory_t category)
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "Literal.hpp"
+#include "SymbolTable.hpp"
+#include "Token.hpp"
+
+namespace peach
+{
+namespace token
+{
+class Token;
+
+// Tokens of single text, stored as parallel arrays
+// Buffer refers to the text, so text must outlive it
+// Line and position in line are not stored, they are computed from line begins index on demand
+// Every token has 32-bit payload: literal tokens keep index of their decoded value in literals side table,
+// name tokens keep id of interned name with SYMBOL_FLAG set, operator tokens keep operator id with OPERATOR_FLAG set
+class TokenBuffer
+{
+public:
+    class const_iterator;
+
+    static constexpr std::size_t MAX_CATEGORY = std::numeric_limits<std::uint8_t>::max();
+    static constexpr std::size_t MAX_TEXT_LENGTH = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t NO_PAYLOAD = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t SYMBOL_FLAG = std::uint32_t(1) << 31;
+    static constexpr std::uint32_t OPERATOR_FLAG = SYMBOL_FLAG | std::uint32_t(1) << 30; // not a literal, not a symbol
+
+    TokenBuffer(std::string_view text = {})
+        : text_(text)
+    {
+        if (text.size() > MAX_TEXT_LENGTH)
+        {
+            throw std::length_error("text is too long to be tokenized");
+        }
+    }
+
+    // Appends token text[offset, offset + length) with category and payload
+    void push(tokenCategory_t category, std::size_t offset, std::size_t length, std::uint32_t payload = NO_PAYLOAD)
+    {
+        if (category > MAX_CATEGORY)
+        {
+            throw std::out_of_range("token category does not fit in token buffer");
+        }
+        categories_.push_back(static_cast<std::uint8_t>(category));
+        offsets_.push_back(static_cast<std::uint32_t>(offset));
+        lengths_.push_back(static_cast<std::uint32_t>(length));
+        payloads_.push_back(payload);
+        if (isEndline(text_[offset]))
+        {
+            lineBegins_.push_back(static_cast<std::uint32_t>(offset + length));
+        }
+    }
+
+    // Removes all tokens and sets text, which next tokens refer to
+    // Memory of buffer is kept, so it is reused by next tokens
+    void reset(std::string_view text)
+    {
+        if (text.size() > MAX_TEXT_LENGTH)
+        {
+            throw std::length_error("text is too long to be tokenized");
+        }
+        text_ = text;
+        categories_.clear();
+        offsets_.clear();
+        lengths_.clear();
+        payloads_.clear();
+        lineBegins_.clear();
+        literals_.clear();
+        firstLine_ = 0;
+    }
+
+    // Reserves memory for count tokens
+    void reserve(std::size_t count)
+    {
+        categories_.reserve(count);
+        offsets_.reserve(count);
+        lengths_.reserve(count);
+        payloads_.reserve(count);
+    }
+
+    // Appends token with decoded literal value
+    void pushLiteral(tokenCategory_t category, std::size_t offset, std::size_t length, LiteralValue value)
+    {
+        if (literals_.size() >= SYMBOL_FLAG)
+        {
+            throw std::length_error("too many literals in token buffer");
+        }
+        push(category, offset, length, static_cast<std::uint32_t>(literals_.size()));
+        literals_.push_back(std::move(value));
+    }
+
+    // Appends name token with id of interned name
+    void pushSymbol(tokenCategory_t category, std::size_t offset, std::size_t length, symbol_t symbol)
+    {
+        push(category, offset, length, makeSymbolPayload(symbol));
+    }
+
+    // Appends operator token with id of its operator
+    void pushOperator(tokenCategory_t category, std::size_t offset, std::size_t length, std::size_t operatorId)
+    {
+        if (operatorId >= (NO_PAYLOAD & ~OPERATOR_FLAG))
+        {
+            throw std::out_of_range("operator id does not fit in token buffer");
+        }
+        push(category, offset, length, static_cast<std::uint32_t>(operatorId) | OPERATOR_FLAG);
+    }
+
+    // Appends tokens of other buffer of the same text, they must follow tokens of this buffer
+    void append(const TokenBuffer &other)
+    {
+        if (other.text_.data() != text_.data() || other.text_.size() != text_.size())
+        {
+            throw std::invalid_argument("only tokens of the same text can be appended");
+        }
+        categories_.insert(categories_.end(), other.categories_.begin(), other.categories_.end());
+        offsets_.insert(offsets_.end(), other.offsets_.begin(), other.offsets_.end());
+        lengths_.insert(lengths_.end(), other.lengths_.begin(), other.lengths_.end());
+        lineBegins_.insert(lineBegins_.end(), other.lineBegins_.begin(), other.lineBegins_.end());
+        // Literal indices of other buffer are shifted by number of literals of this one
+        auto shift = static_cast<std::uint32_t>(literals_.size());
+        for (auto payload : other.payloads_)
+        {
+            payloads_.push_back(payload & SYMBOL_FLAG ? payload : payload + shift);
+        }
+        literals_.insert(literals_.end(), other.literals_.begin(), other.literals_.end());
+    }
+
+    // Inserts token text[offset, offset + length) with category before token id
+    // Tokens must stay ordered by offset, endline tokens can not be inserted
+    void insert(std::size_t id, tokenCategory_t category, std::size_t offset, std::size_t length)
+    {
+        if (category > MAX_CATEGORY || isEndline(text_[offset]))
+        {
+            throw std::invalid_argument("token can not be inserted into token buffer");
+        }
+        categories_.insert(categories_.begin() + id, static_cast<std::uint8_t>(category));
+        offsets_.insert(offsets_.begin() + id, static_cast<std::uint32_t>(offset));
+        lengths_.insert(lengths_.begin() + id, static_cast<std::uint32_t>(length));
+        payloads_.insert(payloads_.begin() + id, NO_PAYLOAD);
+    }
+
+    // Erases tokens [first, last), they must not be endline ones
+    // Decoded values of erased literals stay in side table
+    void erase(std::size_t first, std::size_t last)
+    {
+        categories_.erase(categories_.begin() + first, categories_.begin() + last);
+        offsets_.erase(offsets_.begin() + first, offsets_.begin() + last);
+        lengths_.erase(lengths_.begin() + first, lengths_.begin() + last);
+        payloads_.erase(payloads_.begin() + first, payloads_.begin() + last);
+    }
+
+    std::size_t size() const noexcept { return categories_.size(); }
+    bool empty() const noexcept { return categories_.empty(); }
+    std::string_view getText() const noexcept { return text_; }
+
+    tokenCategory_t getCategory(std::size_t id) const noexcept { return categories_[id]; }
+    std::string_view getTokenString(std::size_t id) const noexcept { return text_.substr(offsets_[id], lengths_[id]); }
+    std::size_t getTextPosition(std::size_t id) const noexcept { return offsets_[id]; }
+    std::uint32_t getPayload(std::size_t id) const noexcept { return payloads_[id]; }
+
+    // Returns decoded value of literal token, nullptr if token is not decoded
+    const LiteralValue *getLiteral(std::size_t id) const noexcept
+    {
+        return payloads_[id] & SYMBOL_FLAG ? nullptr : &literals_[payloads_[id]];
+    }
+
+    // Returns id of interned name of token, NO_SYMBOL if name is not interned
+    symbol_t getSymbol(std::size_t id) const noexcept
+    {
+        std::uint32_t payload = payloads_[id];
+        return (payload & OPERATOR_FLAG) == SYMBOL_FLAG ? payload & ~SYMBOL_FLAG : SymbolTable::NO_SYMBOL;
+    }
+
+    // Returns operator id of token, NO_OPERATOR if lexer has not found it
+    std::size_t getOperatorId(std::size_t id) const noexcept
+    {
+        std::uint32_t payload = payloads_[id];
+        return payload != NO_PAYLOAD && (payload & OPERATOR_FLAG) == OPERATOR_FLAG ? payload & ~OPERATOR_FLAG : NO_OPERATOR;
+    }
+
+    void setSymbol(std::size_t id, symbol_t symbol)
+    {
+        payloads_[id] = makeSymbolPayload(symbol);
+    }
+
+    void setCategory(std::size_t id, tokenCategory_t category)
+    {
+        if (category > MAX_CATEGORY)
+        {
+            throw std::out_of_range("token category does not fit in token buffer");
+        }
+        categories_[id] = static_cast<std::uint8_t>(category);
+    }
+
+    // Returns number of line, token is located on
+    // Endline token belongs to the line it starts
+    std::size_t getLine(std::size_t id) const noexcept
+    {
+        return firstLine_ + getLinesBefore(id) + (isEndline(text_[offsets_[id]]) ? 1 : 0);
+    }
+
+    // Sets number of the first line of text, if text is a part of bigger one
+    void setFirstLine(std::size_t line) noexcept
+    {
+        firstLine_ = line;
+    }
+
+    // Returns position of token in its line
+    std::size_t getLinePosition(std::size_t id) const noexcept
+    {
+        std::size_t lines = getLinesBefore(id);
+        return offsets_[id] - (lines ? lineBegins_[lines - 1] : 0);
+    }
+
+    Token operator[](std::size_t id) const noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+
+private:
+    static std::uint32_t makeSymbolPayload(symbol_t symbol)
+    {
+        if (symbol >= (OPERATOR_FLAG & ~SYMBOL_FLAG))
+        {
+            throw std::out_of_range("symbol does not fit in token buffer");
+        }
+        return symbol | SYMBOL_FLAG;
+    }
+
+    // Returns number of line begins before token
+    std::size_t getLinesBefore(std::size_t id) const noexcept
+    {
+        return std::upper_bound(lineBegins_.begin(), lineBegins_.end(), offsets_[id]) - lineBegins_.begin();
+    }
+
+    std::string_view text_;                 // tokenized text
+    std::vector<std::uint8_t> categories_;  // category of each token
+    std::vector<std::uint32_t> offsets_;    // offset of each token in text
+    std::vector<std::uint32_t> lengths_;    // length of each token
+    std::vector<std::uint32_t> payloads_;   // payload of each token
+    std::vector<std::uint32_t> lineBegins_; // offsets, where lines begin, except the first one
+    std::vector<LiteralValue> literals_;    // decoded values of literal tokens
+    std::size_t firstLine_ = 0;             // number of the first line of text
+};
+
+// Light reference on token in TokenBuffer
+class Token
+{
+public:
+    Token(const TokenBuffer &buffer, std::size_t id)
+        : buffer_(&buffer),
+          id_(id)
+    {
+    }
+
+    tokenCategory_t getCategory() const noexcept { return buffer_->getCategory(id_); }
+    std::string_view getTokenString() const noexcept { return buffer_->getTokenString(id_); }
+    std::size_t getLine() const noexcept { return buffer_->getLine(id_); }
+    std::size_t getLinePosition() const noexcept { return buffer_->getLinePosition(id_); }
+    std::size_t getTextPosition() const noexcept { return buffer_->getTextPosition(id_); }
+    const LiteralValue *getLiteral() const noexcept { return buffer_->getLiteral(id_); }
+    symbol_t getSymbol() const noexcept { return buffer_->getSymbol(id_); }
+    std::size_t getOperatorId() const noexcept { return buffer_->getOperatorId(id_); }
+
+private:
+    const TokenBuffer *buffer_;
+    std::size_t id_;
+};
+
+// Random access iterator over TokenBuffer, it is just an index
+class TokenBuffer::const_iterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Token;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Token;
+
+    // Makes it->getCategory() possible, though iterator returns token by value
+    class ArrowProxy
+    {
+    public:
+        ArrowProxy(Token token)
+            : token_(token) {}
+
+        const Token *operator->() const noexcept { return &token_; }
+
+    private:
+        Token token_;
+    };
+
+    const_iterator() = default;
+
+    const_iterator(const TokenBuffer &buffer, std::size_t id)
+        : buffer_(&buffer),
+          id_(id)
+    {
+    }
+
+    Token operator*() const noexcept { return Token(*buffer_, id_); }
+    ArrowProxy operator->() const noexcept { return ArrowProxy(**this); }
+    Token operator[](difference_type n) const noexcept { return *(*this + n); }
+    std::size_t getIndex() const noexcept { return id_; }
+
+    const_iterator &operator++() noexcept
+    {
+        ++id_;
+        return *this;
+    }
+
+    const_iterator &operator--() noexcept
+    {
+        --id_;
+        return *this;
+    }
+
+    const_iterator operator++(int) noexcept { return const_iterator(*buffer_, id_++); }
+    const_iterator operator--(int) noexcept { return const_iterator(*buffer_, id_--); }
+    const_iterator &operator+=(difference_type n) noexcept { return *this = *this + n; }
+    const_iterator &operator-=(difference_type n) noexcept { return *this = *this - n; }
+    const_iterator operator+(difference_type n) const noexcept { return const_iterator(*buffer_, id_ + n); }
+    const_iterator operator-(difference_type n) const noexcept { return const_iterator(*buffer_, id_ - n); }
+    difference_type operator-(const const_iterator &other) const noexcept { return static_cast<difference_type>(id_) - static_cast<difference_type>(other.id_); }
+
+    bool operator==(const const_iterator &other) const noexcept { return id_ == other.id_; }
+    bool operator!=(const const_iterator &other) const noexcept { return id_ != other.id_; }
+    bool operator<(const const_iterator &other) const noexcept { return id_ < other.id_; }
+    bool operator>(const const_iterator &other) const noexcept { return id_ > other.id_; }
+    bool operator<=(const const_iterator &other) const noexcept { return id_ <= other.id_; }
+    bool operator>=(const const_iterator &other) const noexcept { return id_ >= other.id_; }
+
+private:
+    const TokenBuffer *buffer_ = nullptr;
+    std::size_t id_ = 0;
+};
+
+inline Token TokenBuffer::operator[](std::size_t id) const noexcept
+{
+    return Token(*this, id);
+}
+
+inline TokenBuffer::const_iterator TokenBuffer::begin() const noexcept
+{
+    return const_iterator(*this, 0);
+}
+
+inline TokenBuffer::const_iterator TokenBuffer::end() const noexcept
+{
+    return const_iterator(*this, size());
+}
+
+inline bool isEndline(const Token &tk) noexcept
+{
+    return isEndline(tk.getCategory());
+}
+
+inline bool isSeparator(const Token &tk) noexcept
+{
+    return isSeparator(tk.getCategory());
+}
+
+inline bool isIndentation(const Token &tk) noexcept
+{
+    return isIndentation(tk.getCategory());
+}
+} // namespace token
+} // namespace peach
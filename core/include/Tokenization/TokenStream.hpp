@@ -0,0 +1,85 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+#include "Lexer.hpp"
+#include "SymbolTable.hpp"
+#include "TokenBuffer.hpp"
+
+namespace peach
+{
+namespace fsm
+{
+// Pulls tokens of text from lexer line by line
+// Only tokens of the current line are kept in single buffer, which memory is reused by next lines,
+// so memory of tokens is proportional to the longest line instead of the whole text.
+// Line tokens do not contain endline token, their positions are relative to line.
+// Tokens of lexer must not span several lines.
+class TokenStream
+{
+public:
+    static constexpr std::size_t NONE = Lexer::NONE;
+
+    // Names are interned into symbols, unless it is nullptr
+    // Text must outlive stream and tokens of its lines
+    TokenStream(std::shared_ptr<const Lexer> lexer, std::string_view text, token::SymbolTable *symbols = nullptr)
+        : lexer_(std::move(lexer)),
+          text_(text),
+          symbols_(symbols)
+    {
+        if (!lexer_)
+        {
+            throw std::invalid_argument("nullptr lexer in TokenStream constructor");
+        }
+    }
+
+    // Lexes next line of text into tokens of stream
+    // Returns false, if text is over
+    bool nextLine()
+    {
+        if (pos_ >= text_.size())
+        {
+            tokens_.reset({});
+            firstUndefined_ = NONE;
+            return false;
+        }
+        std::size_t end = std::min(text_.find('\n', pos_), text_.size());
+        tokens_.reset(text_.substr(pos_, end - pos_));
+        tokens_.setFirstLine(line_++);
+        firstUndefined_ = lexer_->tokenizeLine(tokens_, depth_, symbols_);
+        pos_ = end + 1;
+        return true;
+    }
+
+    // Returns tokens of current line
+    const token::TokenBuffer &getTokens() const noexcept
+    {
+        return tokens_;
+    }
+
+    // Returns id of the first undefined token of current line, NONE if it does not have them
+    std::size_t getFirstUndefined() const noexcept
+    {
+        return firstUndefined_;
+    }
+
+    // Returns number of lines, pulled from stream
+    std::size_t getLineCount() const noexcept
+    {
+        return line_;
+    }
+
+private:
+    std::shared_ptr<const Lexer> lexer_; // lexer of lines
+    std::string_view text_;              // text of stream
+    token::SymbolTable *symbols_;        // table, names are interned into
+    token::TokenBuffer tokens_;          // tokens of current line
+    std::size_t pos_ = 0;                // begin of next line in text
+    std::size_t line_ = 0;               // number of next line
+    std::size_t depth_ = 0;              // indentation depth of lexer after current line
+    std::size_t firstUndefined_ = NONE;  // first undefined token of current line
+};
+} // namespace fsm
+} // namespace peach
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <tuple>
 #include <vector>
 
@@ -8,6 +10,57 @@ namespace peach
 {
 namespace transition
 {
+// Set of chars, which can be built and queried at compile time
+class CharSet
+{
+public:
+    constexpr CharSet() = default;
+
+    constexpr bool contains(char c) const noexcept
+    {
+        auto byte = static_cast<unsigned char>(c);
+        return (words_[byte / 64] >> (byte % 64)) & 1;
+    }
+
+    constexpr void insert(char c) noexcept
+    {
+        auto byte = static_cast<unsigned char>(c);
+        words_[byte / 64] |= std::uint64_t(1) << (byte % 64);
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return !(words_[0] | words_[1] | words_[2] | words_[3]);
+    }
+
+    // Returns set of chars, which Transition is active on
+    // Transition must have static constexpr contains(char)
+    template <typename Transition>
+    static constexpr CharSet of() noexcept
+    {
+        CharSet result;
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            if (Transition::contains(static_cast<char>(byte)))
+            {
+                result.insert(static_cast<char>(byte));
+            }
+        }
+        return result;
+    }
+
+    // Returns set of single char
+    static constexpr CharSet single(char c) noexcept
+    {
+        CharSet result;
+        result.insert(c);
+        return result;
+    }
+
+private:
+    std::array<std::uint64_t, 4> words_{};
+};
+
 // Transition for FiniteStateMachine
 class CharTransition
 {
@@ -21,10 +74,15 @@ public:
 class TrueTransition : public CharTransition
 {
 public:
-    bool isActive(char) override
+    static constexpr bool contains(char) noexcept
     {
         return true;
     }
+
+    bool isActive(char c) override
+    {
+        return contains(c);
+    }
 };
 
 // Merge of TransitionClasses
@@ -34,6 +92,12 @@ template <typename... TransitionClasses> // TODO: sfinae for default-constructio
 class MergeTransitions : public CharTransition
 {
 public:
+    // Is available, if all TransitionClasses have it
+    static constexpr bool contains(char c) noexcept
+    {
+        return (... || TransitionClasses::contains(c));
+    }
+
     bool isActive(char c) override
     {
         return std::apply(
@@ -98,6 +162,11 @@ class RangeCharTransitionTemplate : public RangeCharTransition
 public:
     RangeCharTransitionTemplate()
         : RangeCharTransition(Begin, End) {}
+
+    static constexpr bool contains(char c) noexcept
+    {
+        return Begin <= c && c <= End;
+    }
 };
 
 // Template for SingleCharTransition
@@ -107,6 +176,11 @@ class SingleCharTransitionTemplate : public RangeCharTransition
 public:
     SingleCharTransitionTemplate()
         : RangeCharTransition(C, C) {}
+
+    static constexpr bool contains(char c) noexcept
+    {
+        return c == C;
+    }
 };
 
 // Transition that is active iff Transition is not active
@@ -114,6 +188,12 @@ template <class Transition> // TODO: put SFINAE here, requires 'bool Transition:
 class TransitionNegation : public Transition
 {
 public:
+    // Is available, if Transition has it
+    static constexpr bool contains(char c) noexcept
+    {
+        return !Transition::contains(c);
+    }
+
     bool isActive(char c) override
     {
         return !Transition::isActive(c);
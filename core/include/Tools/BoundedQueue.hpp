@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+namespace peach
+{
+namespace tools
+{
+// Queue of limited capacity, which passes items from producer threads to consumer threads
+// Producer waits while queue is full, consumer waits while it is empty.
+// Queue is closed by producer, after that consumers get remaining items and then nothing.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity)
+        : capacity_(capacity)
+    {
+        if (capacity_ == 0)
+        {
+            throw std::invalid_argument("bounded queue must have positive capacity");
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    // Appends item, waits for free place, if queue is full
+    // Throws std::logic_error, if queue is closed
+    void push(T item)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+            if (closed_)
+            {
+                throw std::logic_error("push to closed bounded queue");
+            }
+            items_.push_back(std::move(item));
+        }
+        notEmpty_.notify_one();
+    }
+
+    // Removes the first item, waits for it, if queue is empty
+    // Returns nothing, if queue is closed and empty
+    std::optional<T> pop()
+    {
+        std::optional<T> item;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+            if (items_.empty())
+            {
+                return item;
+            }
+            item.emplace(std::move(items_.front()));
+            items_.pop_front();
+        }
+        notFull_.notify_one();
+        return item;
+    }
+
+    // Returns if queue has no items now
+    bool empty() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.empty();
+    }
+
+    // Closes queue, waiting consumers get remaining items and then nothing
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;              // maximal number of items
+    std::deque<T> items_;               // items in push order
+    mutable std::mutex mutex_;          // guards items_ and closed_
+    std::condition_variable notEmpty_;  // notifies consumers about new items and close
+    std::condition_variable notFull_;   // notifies producers about free place and close
+    bool closed_ = false;               // if producer has finished
+};
+} // namespace tools
+} // namespace peach
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define PEACH_CODE_CACHE_SUPPORTED
+#endif
+
+namespace peach
+{
+namespace tools
+{
+// Keeps generated machine code in executable memory
+// Every code gets its own pages, which are writable while code is copied and only executable after that,
+// so memory is never writable and executable at the same time. Pages are unmapped, when code is removed, or with cache.
+class CodeCache
+{
+public:
+    // Returns if executable memory is supported on this platform
+    static constexpr bool isSupported() noexcept
+    {
+#ifdef PEACH_CODE_CACHE_SUPPORTED
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    CodeCache() = default;
+    CodeCache(const CodeCache &) = delete;
+    CodeCache &operator=(const CodeCache &) = delete;
+
+    ~CodeCache()
+    {
+#ifdef PEACH_CODE_CACHE_SUPPORTED
+        for (const auto &block : blocks_)
+        {
+            munmap(block.memory, block.size);
+        }
+#endif
+    }
+
+    // Copies code to new executable pages, returns its address
+    // Throws std::runtime_error, if memory can not be mapped or protected
+    const void *add(const std::vector<std::uint8_t> &code)
+    {
+#ifdef PEACH_CODE_CACHE_SUPPORTED
+        auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t size = (code.size() + pageSize - 1) / pageSize * pageSize;
+        void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::runtime_error("can not map memory for generated code");
+        }
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, size);
+            throw std::runtime_error("can not make generated code executable");
+        }
+        blocks_.push_back({memory, size});
+        return memory;
+#else
+        (void)code;
+        throw std::runtime_error("executable memory is not supported on this platform");
+#endif
+    }
+
+    // Unmaps pages of code, which add returned
+    void remove(const void *code) noexcept
+    {
+        auto block = std::find_if(blocks_.begin(), blocks_.end(), [code](const Block &candidate) {
+            return candidate.memory == code;
+        });
+        if (block == blocks_.end())
+        {
+            return;
+        }
+#ifdef PEACH_CODE_CACHE_SUPPORTED
+        munmap(block->memory, block->size);
+#endif
+        blocks_.erase(block);
+    }
+
+private:
+    struct Block
+    {
+        void *memory;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks_; // mapped pages of each code
+};
+} // namespace tools
+} // namespace peach
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "TokenBuffer.hpp"
+
+namespace peach
+{
+namespace exception
+{
+// Code of positional error, which is found in program
+enum class ErrorCode : std::uint8_t
+{
+    INDENTATION,
+    SYNTAX,
+    INVALID_VARIABLE_DECLARATION,
+    UNDEFINED_TOKEN,
+    UNEXPECTED_TOKEN,
+    UNEXPECTED_ELSE,
+    UNDEFINED_OPERATOR,
+    BRACKET_DISBALANCE,
+    INVALID_ASSIGNATION,
+    UNKNOWN_VARIABLE,
+    VARIABLE_REDECLARATION,
+};
+
+// Positional error, found in program, as compact record
+// Its message is formatted only when it is needed, so reporting errors does not allocate
+struct Diagnostic
+{
+    std::uint32_t line;
+    std::uint32_t position;
+    ErrorCode code;
+};
+
+// Returns name of error class of code
+inline const char *getErrorClass(ErrorCode code) noexcept
+{
+    switch (code)
+    {
+    case ErrorCode::INDENTATION:
+        return "IndentationError";
+    case ErrorCode::SYNTAX:
+        return "SyntaxError";
+    case ErrorCode::INVALID_VARIABLE_DECLARATION:
+        return "InvalidVariableDeclarationError";
+    case ErrorCode::UNDEFINED_TOKEN:
+        return "UndefinedTokenError";
+    case ErrorCode::UNEXPECTED_TOKEN:
+        return "UnexpectedTokenError";
+    case ErrorCode::UNEXPECTED_ELSE:
+        return "UnexpectedElseError";
+    case ErrorCode::UNDEFINED_OPERATOR:
+        return "UndefinedOperatorError";
+    case ErrorCode::BRACKET_DISBALANCE:
+        return "BracketDisbalanceError";
+    case ErrorCode::INVALID_ASSIGNATION:
+        return "InvalidAssignationError";
+    case ErrorCode::UNKNOWN_VARIABLE:
+        return "UnknownVariableError";
+    case ErrorCode::VARIABLE_REDECLARATION:
+        return "VariableRedeclaration";
+    }
+    return "UnknownError";
+}
+
+// Returns description of error of code
+inline const char *getErrorComment(ErrorCode code) noexcept
+{
+    switch (code)
+    {
+    case ErrorCode::INDENTATION:
+        return "bad indentation";
+    case ErrorCode::SYNTAX:
+        return "invalid syntax";
+    case ErrorCode::INVALID_VARIABLE_DECLARATION:
+        return "name expected";
+    case ErrorCode::UNDEFINED_TOKEN:
+        return "can not recognize token";
+    case ErrorCode::UNEXPECTED_TOKEN:
+        return "token is not expected";
+    case ErrorCode::UNEXPECTED_ELSE:
+        return "can not process 'else' if it not preceded by 'if'";
+    case ErrorCode::UNDEFINED_OPERATOR:
+        return "can't find operator";
+    case ErrorCode::BRACKET_DISBALANCE:
+        return "can't match bracket";
+    case ErrorCode::INVALID_ASSIGNATION:
+        return "left expression must be variable access";
+    case ErrorCode::UNKNOWN_VARIABLE:
+        return "variable is not visible";
+    case ErrorCode::VARIABLE_REDECLARATION:
+        return "variable is declared already";
+    }
+    return "unknown error";
+}
+
+// Returns message of positional error, like what() of its exception
+inline std::string formatDiagnostic(ErrorCode code, std::size_t line, std::size_t position)
+{
+    return std::string(getErrorClass(code)) + ": " + getErrorComment(code) + " at " +
+           std::to_string(line) + ":" + std::to_string(position);
+}
+
+inline std::string formatDiagnostic(const Diagnostic &diagnostic)
+{
+    return formatDiagnostic(diagnostic.code, diagnostic.line, diagnostic.position);
+}
+
+// Returns diagnostic of error of code at token
+inline Diagnostic makeDiagnostic(ErrorCode code, const token::TokenBuffer::const_iterator &it) noexcept
+{
+    return {static_cast<std::uint32_t>(it->getLine()), static_cast<std::uint32_t>(it->getLinePosition()), code};
+}
+} // namespace exception
+} // namespace peach
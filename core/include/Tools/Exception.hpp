@@ -2,7 +2,8 @@
 
 #include <stdexcept>
 
-#include "Token.hpp"
+#include "Diagnostic.hpp"
+#include "TokenBuffer.hpp"
 
 namespace peach
 {
@@ -31,31 +32,33 @@ class PositionalError : public PeachException
 public:
     PositionalError(std::size_t line,
                     std::size_t position,
-                    const std::string &exceptionClass,
-                    const std::string &comment)
-        : PeachException(exceptionClass,
-                         comment + " at " +
+                    ErrorCode code)
+        : PeachException(getErrorClass(code),
+                         std::string(getErrorComment(code)) + " at " +
                              std::to_string(line) +
                              ":" + std::to_string(position)),
           line_(line),
-          position_(position)
+          position_(position),
+          code_(code)
     {
     }
 
     std::size_t getLine() const noexcept { return line_; }
     std::size_t getPosition() const noexcept { return position_; }
+    ErrorCode getCode() const noexcept { return code_; }
 
 private:
     const std::size_t line_, position_;
+    const ErrorCode code_;
 };
 
 template <typename ExceptionT,
           typename = decltype(std::declval<ExceptionT>().getLine()),
           typename = decltype(std::declval<ExceptionT>().getPosition())> // TODO: sfinae!
-inline void throwFromTokenIterator(const std::vector<token::TokenPtr>::iterator &it)
+inline void throwFromTokenIterator(const token::TokenBuffer::const_iterator &it)
 {
-    throw ExceptionT((*it)->getLine(),
-                     (*it)->getLinePosition());
+    throw ExceptionT(it->getLine(),
+                     it->getLinePosition());
 }
 
 template <typename ExceptionT> // TODO: sfinae!
@@ -71,7 +74,7 @@ public:
                      std::size_t position)
         : PositionalError(line,
                           position,
-                          "IndentationError", "bad indentation")
+                          ErrorCode::INDENTATION)
     {
     }
 };
@@ -83,7 +86,7 @@ public:
                 std::size_t position)
         : PositionalError(line,
                           position,
-                          "SyntaxError", "invalid syntax")
+                          ErrorCode::SYNTAX)
     {
     }
 };
@@ -95,7 +98,7 @@ public:
                                     std::size_t position)
         : PositionalError(line,
                           position,
-                          "InvalidVariableDeclarationError", "name expected")
+                          ErrorCode::INVALID_VARIABLE_DECLARATION)
     {
     }
 };
@@ -107,7 +110,7 @@ public:
                         std::size_t position)
         : PositionalError(line,
                           position,
-                          "UndefinedTokenError", "can not recognize token")
+                          ErrorCode::UNDEFINED_TOKEN)
     {
     }
 };
@@ -119,7 +122,7 @@ public:
                          std::size_t position)
         : PositionalError(line,
                           position,
-                          "UnexpectedTokenError", "token is not expected")
+                          ErrorCode::UNEXPECTED_TOKEN)
     {
     }
 };
@@ -131,7 +134,7 @@ public:
                         std::size_t position)
         : PositionalError(line,
                           position,
-                          "UnexpectedElseError", "can not process 'else' if it not preceded by 'if'")
+                          ErrorCode::UNEXPECTED_ELSE)
     {
     }
 };
@@ -143,7 +146,7 @@ public:
                            std::size_t position)
         : PositionalError(line,
                           position,
-                          "UndefinedOperatorError", "can't find operator")
+                          ErrorCode::UNDEFINED_OPERATOR)
     {
     }
 };
@@ -155,7 +158,7 @@ public:
                            std::size_t position)
         : PositionalError(line,
                           position,
-                          "BracketDisbalanceError", "can't match bracket")
+                          ErrorCode::BRACKET_DISBALANCE)
     {
     }
 };
@@ -167,7 +170,7 @@ public:
                             std::size_t position)
         : PositionalError(line,
                           position,
-                          "InvalidAssignationError", "left expression must be variable access")
+                          ErrorCode::INVALID_ASSIGNATION)
     {
     }
 };
@@ -179,7 +182,7 @@ public:
                          std::size_t position)
         : PositionalError(line,
                           position,
-                          "UnknownVariableError", "variable is not visible")
+                          ErrorCode::UNKNOWN_VARIABLE)
     {
     }
 };
@@ -191,11 +194,42 @@ public:
                           std::size_t position)
         : PositionalError(line,
                           position,
-                          "VariableRedeclaration", "variable is declared already")
+                          ErrorCode::VARIABLE_REDECLARATION)
     {
     }
 };
 
+// Throws exception of positional error of diagnostic
+[[noreturn]] inline void throwDiagnostic(const Diagnostic &diagnostic)
+{
+    switch (diagnostic.code)
+    {
+    case ErrorCode::INDENTATION:
+        throw IndentationError(diagnostic.line, diagnostic.position);
+    case ErrorCode::SYNTAX:
+        throw SyntaxError(diagnostic.line, diagnostic.position);
+    case ErrorCode::INVALID_VARIABLE_DECLARATION:
+        throw InvalidVariableDeclarationError(diagnostic.line, diagnostic.position);
+    case ErrorCode::UNDEFINED_TOKEN:
+        throw UndefinedTokenError(diagnostic.line, diagnostic.position);
+    case ErrorCode::UNEXPECTED_TOKEN:
+        throw UnexpectedTokenError(diagnostic.line, diagnostic.position);
+    case ErrorCode::UNEXPECTED_ELSE:
+        throw UnexpectedElseError(diagnostic.line, diagnostic.position);
+    case ErrorCode::UNDEFINED_OPERATOR:
+        throw UndefinedOperatorError(diagnostic.line, diagnostic.position);
+    case ErrorCode::BRACKET_DISBALANCE:
+        throw BracketDisbalanceError(diagnostic.line, diagnostic.position);
+    case ErrorCode::INVALID_ASSIGNATION:
+        throw InvalidAssignationError(diagnostic.line, diagnostic.position);
+    case ErrorCode::UNKNOWN_VARIABLE:
+        throw UnknownVariableError(diagnostic.line, diagnostic.position);
+    case ErrorCode::VARIABLE_REDECLARATION:
+        throw VariableRedeclaration(diagnostic.line, diagnostic.position);
+    }
+    throw PositionalError(diagnostic.line, diagnostic.position, diagnostic.code);
+}
+
 class InterruptionError : public PeachException
 {
 public:
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace peach
+{
+namespace tools
+{
+// Fixed set of worker threads, which run submitted tasks in submission order
+class ThreadPool
+{
+public:
+    // Starts threadsCount workers, one per hardware thread by default
+    explicit ThreadPool(std::size_t threadsCount = std::thread::hardware_concurrency())
+    {
+        threadsCount = std::max<std::size_t>(threadsCount, 1);
+        for (std::size_t id = 0; id < threadsCount; ++id)
+        {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Finishes queued tasks and joins workers
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        wakeup_.notify_all();
+        for (auto &worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    // Queues task
+    // Returns future of its result, exception of task is rethrown from future
+    template <typename Func>
+    auto submit(Func &&func) -> std::future<decltype(func())>
+    {
+        using Result = decltype(func());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([task]() { (*task)(); });
+        }
+        wakeup_.notify_one();
+        return result;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return workers_.size();
+    }
+
+private:
+    // Runs tasks, until pool is stopped and queue is empty
+    void work()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeup_.wait(lock, [this]() { return stopped_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;        // worker threads
+    std::queue<std::function<void()>> tasks_; // tasks, which are not started yet
+    std::mutex mutex_;                        // guards tasks_ and stopped_
+    std::condition_variable wakeup_;          // notifies workers about new tasks and stop
+    bool stopped_ = false;                    // if pool is being destroyed
+};
+} // namespace tools
+} // namespace peach
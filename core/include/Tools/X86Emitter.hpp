@@ -0,0 +1,327 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace peach
+{
+namespace tools
+{
+// Emits x86-64 machine code of small set of instructions into byte buffer
+// Operations on values are 32 bit, pointers are 64 bit. Memory operands are [base + disp32].
+// Jumps are 32 bit relative, their targets are labels, which are bound later or earlier.
+class X86Emitter
+{
+public:
+    enum Register : std::uint8_t
+    {
+        RAX,
+        RCX,
+        RDX,
+        RBX,
+        RSP,
+        RBP,
+        RSI,
+        RDI,
+        R8,
+        R9,
+        R10,
+        R11,
+        R12,
+        R13,
+        R14,
+        R15,
+    };
+
+    // Condition codes of jcc and setcc
+    enum Condition : std::uint8_t
+    {
+        EQUAL = 0x4,
+        NOT_EQUAL = 0x5,
+        LESS = 0xC,
+        GREATER_EQUAL = 0xD,
+        LESS_EQUAL = 0xE,
+        GREATER = 0xF,
+    };
+
+    // Label is index of position in code, it is unbound until bind call
+    using Label = std::size_t;
+
+    Label makeLabel()
+    {
+        labels_.push_back(UNBOUND);
+        return labels_.size() - 1;
+    }
+
+    // Binds label to the current position
+    void bind(Label label)
+    {
+        labels_.at(label) = code_.size();
+    }
+
+    // mov dst, src (32 bit)
+    void mov(Register dst, Register src)
+    {
+        emitRegReg(0x89, src, dst);
+    }
+
+    // mov dst, imm32
+    void mov(Register dst, std::int32_t imm)
+    {
+        emitRex(false, 0, 0, dst);
+        emitByte(0xB8 + (dst & 7));
+        emitImm32(static_cast<std::uint32_t>(imm));
+    }
+
+    // mov dst, imm64
+    void mov64(Register dst, std::uint64_t imm)
+    {
+        emitRex(true, 0, 0, dst);
+        emitByte(0xB8 + (dst & 7));
+        for (int i = 0; i < 8; ++i)
+        {
+            emitByte(static_cast<std::uint8_t>(imm >> (8 * i)));
+        }
+    }
+
+    // mov dst, src (64 bit)
+    void mov64(Register dst, Register src)
+    {
+        emitRex(true, src, 0, dst);
+        emitByte(0x89);
+        emitModRm(3, src, dst);
+    }
+
+    // mov dst, dword [base + disp]
+    void load(Register dst, Register base, std::int32_t disp)
+    {
+        emitMem(false, 0x8B, dst, base, disp);
+    }
+
+    // mov dst, qword [base + disp]
+    void load64(Register dst, Register base, std::int32_t disp)
+    {
+        emitMem(true, 0x8B, dst, base, disp);
+    }
+
+    // mov dword [base + disp], src
+    void store(Register base, std::int32_t disp, Register src)
+    {
+        emitMem(false, 0x89, src, base, disp);
+    }
+
+    void add(Register dst, Register src) { emitRegReg(0x01, src, dst); }
+    void sub(Register dst, Register src) { emitRegReg(0x29, src, dst); }
+    void bitAnd(Register dst, Register src) { emitRegReg(0x21, src, dst); }
+    void bitOr(Register dst, Register src) { emitRegReg(0x09, src, dst); }
+    void cmp(Register left, Register right) { emitRegReg(0x39, right, left); }
+    void test(Register left, Register right) { emitRegReg(0x85, right, left); }
+
+    // imul dst, src
+    void imul(Register dst, Register src)
+    {
+        emitRex(false, dst, 0, src);
+        emitByte(0x0F);
+        emitByte(0xAF);
+        emitModRm(3, dst, src);
+    }
+
+    // cmp reg, imm8
+    void cmp(Register reg, std::int8_t imm)
+    {
+        emitRex(false, 0, 0, reg);
+        emitByte(0x83);
+        emitModRm(3, 7, reg);
+        emitByte(static_cast<std::uint8_t>(imm));
+    }
+
+    // cdq: sign extends eax into edx
+    void cdq()
+    {
+        emitByte(0x99);
+    }
+
+    // idiv divisor: eax = edx:eax / divisor, edx = edx:eax % divisor
+    void idiv(Register divisor)
+    {
+        emitRex(false, 0, 0, divisor);
+        emitByte(0xF7);
+        emitModRm(3, 7, divisor);
+    }
+
+    // setcc al
+    void setAl(Condition condition)
+    {
+        emitByte(0x0F);
+        emitByte(0x90 + condition);
+        emitModRm(3, 0, RAX);
+    }
+
+    // setcc cl
+    void setCl(Condition condition)
+    {
+        emitByte(0x0F);
+        emitByte(0x90 + condition);
+        emitModRm(3, 0, RCX);
+    }
+
+    // and al, cl
+    void andAlCl()
+    {
+        emitByte(0x20);
+        emitModRm(3, RCX, RAX);
+    }
+
+    // movzx dst, al
+    void movzxAl(Register dst)
+    {
+        emitRex(false, dst, 0, 0);
+        emitByte(0x0F);
+        emitByte(0xB6);
+        emitModRm(3, dst, RAX);
+    }
+
+    void push(Register reg)
+    {
+        emitRex(false, 0, 0, reg);
+        emitByte(0x50 + (reg & 7));
+    }
+
+    void pop(Register reg)
+    {
+        emitRex(false, 0, 0, reg);
+        emitByte(0x58 + (reg & 7));
+    }
+
+    // sub rsp, imm8
+    void subRsp(std::int8_t imm)
+    {
+        emitByte(0x48);
+        emitByte(0x83);
+        emitModRm(3, 5, RSP);
+        emitByte(static_cast<std::uint8_t>(imm));
+    }
+
+    // add rsp, imm8
+    void addRsp(std::int8_t imm)
+    {
+        emitByte(0x48);
+        emitByte(0x83);
+        emitModRm(3, 0, RSP);
+        emitByte(static_cast<std::uint8_t>(imm));
+    }
+
+    // call reg
+    void call(Register reg)
+    {
+        emitRex(false, 0, 0, reg);
+        emitByte(0xFF);
+        emitModRm(3, 2, reg);
+    }
+
+    void ret()
+    {
+        emitByte(0xC3);
+    }
+
+    void jmp(Label target)
+    {
+        emitByte(0xE9);
+        emitJumpTarget(target);
+    }
+
+    void jcc(Condition condition, Label target)
+    {
+        emitByte(0x0F);
+        emitByte(0x80 + condition);
+        emitJumpTarget(target);
+    }
+
+    // Returns code with resolved jumps, all used labels must be bound
+    std::vector<std::uint8_t> finish()
+    {
+        for (const auto &jump : jumps_)
+        {
+            if (labels_[jump.label] == UNBOUND)
+            {
+                throw std::logic_error("jump to unbound label");
+            }
+            auto rel = static_cast<std::int32_t>(static_cast<std::int64_t>(labels_[jump.label]) - static_cast<std::int64_t>(jump.position + 4));
+            std::memcpy(code_.data() + jump.position, &rel, sizeof(rel));
+        }
+        return code_;
+    }
+
+private:
+    static constexpr std::size_t UNBOUND = static_cast<std::size_t>(-1);
+
+    // Place of rel32 of jump to label
+    struct Jump
+    {
+        std::size_t position;
+        Label label;
+    };
+
+    void emitByte(std::uint8_t byte)
+    {
+        code_.push_back(byte);
+    }
+
+    void emitImm32(std::uint32_t imm)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            emitByte(static_cast<std::uint8_t>(imm >> (8 * i)));
+        }
+    }
+
+    // Emits REX prefix, if operation is 64 bit or uses extended registers
+    void emitRex(bool wide, std::uint8_t reg, std::uint8_t index, std::uint8_t rm)
+    {
+        std::uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((index & 8) ? 0x02 : 0) | ((rm & 8) ? 0x01 : 0);
+        if (rex != 0x40)
+        {
+            emitByte(rex);
+        }
+    }
+
+    void emitModRm(std::uint8_t mod, std::uint8_t reg, std::uint8_t rm)
+    {
+        emitByte(static_cast<std::uint8_t>((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+    }
+
+    // op r/m32, r32 with register operands
+    void emitRegReg(std::uint8_t opcode, Register reg, Register rm)
+    {
+        emitRex(false, reg, 0, rm);
+        emitByte(opcode);
+        emitModRm(3, reg, rm);
+    }
+
+    // op with [base + disp32] operand, base rsp and r12 need SIB byte
+    void emitMem(bool wide, std::uint8_t opcode, Register reg, Register base, std::int32_t disp)
+    {
+        emitRex(wide, reg, 0, base);
+        emitByte(opcode);
+        emitModRm(2, reg, base);
+        if ((base & 7) == RSP)
+        {
+            emitByte(0x24);
+        }
+        emitImm32(static_cast<std::uint32_t>(disp));
+    }
+
+    void emitJumpTarget(Label target)
+    {
+        jumps_.push_back({code_.size(), target});
+        emitImm32(0);
+    }
+
+    std::vector<std::uint8_t> code_;  // emitted code
+    std::vector<std::size_t> labels_; // position of each label
+    std::vector<Jump> jumps_;         // jumps, which are resolved on finish
+};
+} // namespace tools
+} // namespace peach
@@ -0,0 +1,185 @@
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Bytecode.hpp"
+#include "LoopJit.hpp"
+#include "PeachCli.hpp"
+
+namespace
+{
+using namespace peach;
+
+// Engine, which evaluates expression in scope
+using Engine = std::function<expression::VType(const expression::ExprShPtr &, expression::Scope &)>;
+
+// Returns value or error of evaluation and values of all variables after it
+std::string run(const Engine &engine, const expression::ExprShPtr &expression, const std::shared_ptr<token::SymbolTable> &symbols)
+{
+    expression::Scope scope(symbols);
+    std::string result;
+    try
+    {
+        result = std::to_string(engine(expression, scope));
+    }
+    catch (const std::exception &e)
+    {
+        result = e.what();
+    }
+    for (token::symbol_t symbol = 0; symbol < symbols->size(); ++symbol)
+    {
+        if (auto value = scope.find(symbol))
+        {
+            result += " " + std::string(symbols->getName(symbol)) + "=" + std::to_string(*value);
+        }
+    }
+    return result;
+}
+
+expression::VType evaluateTree(const expression::ExprShPtr &expression, expression::Scope &scope)
+{
+    return expression->eval(scope);
+}
+
+const expression::ArenaExpression &getArenaExpression(const expression::ExprShPtr &expression)
+{
+    auto arenaExpression = std::dynamic_pointer_cast<expression::ArenaExpression>(expression);
+    if (!arenaExpression)
+    {
+        throw std::logic_error("interpretated script is not arena expression");
+    }
+    return *arenaExpression;
+}
+
+expression::VType evaluateBytecode(const expression::ExprShPtr &expression, expression::Scope &scope)
+{
+    return expression::BytecodeExpression(getArenaExpression(expression)).eval(scope);
+}
+
+// Script, which every engine runs
+struct EngineCase
+{
+    std::string name;
+    std::string script;
+    bool hostOperators = false; // script is interpretated with operators of host instead of cli ones
+    int compiledLoops = 0;      // loops, which JIT compiles, if it is supported, -1 if it is not checked
+};
+
+// Interpreter, which operators are functions of host, they are called back by every engine
+interpreter::Interpreter makeHostInterpreter()
+{
+    using expression::PeachTuple;
+    using expression::VType;
+    interpreter::Interpreter interpreter(
+        {token::tokenCategory::SEP_TAB},
+        {
+            {[](PeachTuple args) { return VType(!args[0]); }, "!", token::tokenCategory::OPERATOR_UN},
+            {[](PeachTuple args) { return VType(args[0] * 3 + args[1]); }, "*", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) -> VType {
+                 if (args[1] == 7)
+                 {
+                     throw std::runtime_error("host operator rejects 7");
+                 }
+                 return args[0] / (args[1] == 0 ? 1 : args[1]);
+             },
+             "/", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] + args[1]); }, "+", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] - args[1]); }, "-", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] < args[1]); }, "<", token::tokenCategory::OPERATOR_BI},
+        },
+        {
+            {[](VType &left, VType right) { left = right; }, "=", token::tokenCategory::ASSIGNMENT},
+            {[](VType &left, VType right) { left += 2 * right; }, "+=", token::tokenCategory::ASSIGNMENT},
+        });
+    interpreter.setOperatorPatterns(cli::PeachCli::OPERATORS);
+    return interpreter;
+}
+
+// Interpretates script, returns its expression and symbols of its variables
+std::pair<expression::ExprShPtr, std::shared_ptr<token::SymbolTable>> interpretate(const EngineCase &engineCase)
+{
+    cli::PeachCli cli;
+    if (!engineCase.hostOperators)
+    {
+        return {cli.interpretateProgram(engineCase.script), cli.getScope().getSymbolTable()};
+    }
+    auto interpreter = makeHostInterpreter();
+    auto tokens = cli.getLexer()->tokenize(engineCase.script, interpreter.getSymbolTable().get());
+    interpreter.interpretateLines(tokens.begin(), tokens.end());
+    return {interpreter.getInterpretationResult(), interpreter.getSymbolTable()};
+}
+
+const std::vector<EngineCase> CASES = {
+    {"arithmetic",
+     "let a = 17\nlet b = 5\na * b - a / b + a % b - (a == 17) + (a != b) * 3 + (a > b) - (a < b) + (a | 0) + (b & a)\n"},
+    {"conditionals",
+     "let a = 3\nlet r = 0\nif a > 2\n\tif a < 3\n\t\tr = 1\n\telse\n\t\tr = 2\nelse\n\tr = 3\nr\n"},
+    {"assignments",
+     "let a = 100\na += 5\na -= 3\na *= 2\na /= 7\na %= 11\na &= 6\na |= 9\na\n"},
+    {"pow",
+     "let a = 3 ** 4\nlet b = 2 ** 0\nlet c = 5 ** 3 ** 2\nlet d = (0 - 2) ** 3\nlet e = 0 ** 0\na + b + c + d + e\n"},
+    {"loop",
+     "let i = 0\nlet s = 0\nwhile i < 2000\n\ts += i * i % 7\n\ti += 1\ns\n", false, 1},
+    {"nested loops",
+     "let i = 0\nlet j = 0\nlet s = 0\nwhile i < 40\n\tj = i\n\twhile j < 60\n\t\ts += i ** 2 - j\n\t\tj += 1\n\ti += 1\ns\n", false, 1},
+    {"nested hot loops",
+     "let i = 0\nlet j = 0\nlet s = 0\nwhile i < 1500\n\tj = 0\n\twhile j < 3\n\t\ts += i / (j + 1)\n\t\tj += 1\n\ti += 1\ns\n", false, 2},
+    {"loop with declaration",
+     "let i = 0\nlet s = 0\nwhile i < 2000\n\tif i == 0\n\t\tlet t = 5\n\tt += i % 3\n\ts += t\n\ti += 1\ns\n"},
+    {"redeclaration in loop",
+     "let i = 0\nlet s = 0\nwhile i < 3\n\tlet t = i * 2\n\ts += t\n\ti += 1\ns\n"},
+    {"division by zero in loop",
+     "let i = 0\nlet s = 0\nwhile i < 3000\n\ts += 100 / (i - 2500)\n\ti += 1\ns\n", false, 1},
+    {"division by -1 and zero in loop",
+     "let i = 0\nlet s = 0\nwhile i < 3000\n\ts += 7 / (2001 - i) + i % 3\n\ti += 1\ns\n", false, 1},
+    {"unknown variable",
+     "let a = 1\nif a\n\tb = 2\na\n"},
+    {"host operators",
+     "let a = 4\nlet b = 0\nwhile b < 150000\n\tb += a * 2 - !a\n\ta = a / 3 + 4\nb\n", true, 1},
+    {"host operator error in loop",
+     "let a = 0\nlet b = 0\nwhile a < 3000\n\tb = b + 14 / (a - 2000)\n\ta = a + 1\nb\n", true, 1},
+};
+} // namespace
+
+// Runs scripts on tree walking, bytecode and JIT engines, they must give the same results, errors and variables
+// Every script is run by JIT twice, the second run starts with loops, which the first one has compiled
+int main()
+{
+    int failed = 0;
+    for (const auto &engineCase : CASES)
+    {
+        auto [expression, symbols] = interpretate(engineCase);
+        std::string tree = run(evaluateTree, expression, symbols);
+        std::vector<std::pair<std::string, std::string>> results;
+        results.emplace_back("bytecode", run(evaluateBytecode, expression, symbols));
+
+        expression::BytecodeExpression bytecode(getArenaExpression(expression));
+        expression::LoopJit jit;
+        auto evaluateJit = [&](const expression::ExprShPtr &, expression::Scope &scope) {
+            return bytecode.getProgram().run(scope, &jit);
+        };
+        results.emplace_back("jit", run(evaluateJit, expression, symbols));
+        results.emplace_back("hot jit", run(evaluateJit, expression, symbols));
+
+        for (const auto &[engine, result] : results)
+        {
+            if (result != tree)
+            {
+                ++failed;
+                std::cerr << engineCase.name << " failed\ntree: " << tree << '\n'
+                          << engine << ": " << result << '\n';
+            }
+        }
+        if (expression::LoopJit::isSupported() && engineCase.compiledLoops >= 0 &&
+            jit.getCompiledLoops() != static_cast<std::size_t>(engineCase.compiledLoops))
+        {
+            ++failed;
+            std::cerr << engineCase.name << " failed: JIT has compiled " << jit.getCompiledLoops() << " loops instead of "
+                      << engineCase.compiledLoops << '\n';
+        }
+    }
+    return failed;
+}
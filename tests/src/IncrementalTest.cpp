@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "PeachCli.hpp"
+
+namespace
+{
+using namespace peach;
+
+// Lines of edits: statements, blocks, 'else', broken and too deep lines
+// There are no loops, so lines of any order terminate
+const std::vector<std::string> LINES = {
+    "let a = 1",
+    "let b = 2",
+    "let c",
+    "a += b",
+    "b = b * 3 - a",
+    "if a > 3",
+    "\tb += 1",
+    "\tif b > 4",
+    "\t\ta -= 2",
+    "\t\tlet d = a",
+    "else",
+    "\telse",
+    "\ta = 7",
+    "",
+    "a = (1",
+    "b = ? 2",
+    "c = 1 +",
+    "let 4",
+    "\t\t\tb = 1",
+    "c = a / (b - b)",
+    "a",
+};
+
+// Returns value or error of expression and values of all variables after it
+std::string run(const std::function<expression::ExprShPtr()> &interpretate, const std::shared_ptr<token::SymbolTable> &symbols)
+{
+    expression::Scope scope(symbols);
+    std::string result;
+    try
+    {
+        result = std::to_string(interpretate()->eval(scope));
+    }
+    catch (const std::exception &e)
+    {
+        result = e.what();
+    }
+    for (token::symbol_t symbol = 0; symbol < symbols->size(); ++symbol)
+    {
+        if (auto value = scope.find(symbol))
+        {
+            result += " " + std::string(symbols->getName(symbol)) + "=" + std::to_string(*value);
+        }
+    }
+    return result;
+}
+
+// Returns text of random lines
+std::string makeText(std::mt19937 &random, std::size_t maxLines)
+{
+    std::string text;
+    for (std::size_t count = random() % (maxLines + 1); count > 0; --count)
+    {
+        text += LINES[random() % LINES.size()] + '\n';
+    }
+    return text;
+}
+} // namespace
+
+// Edits programs by random lines, after every edit incremental program must have the same text,
+// result, error and variables, as the whole text interpretated again
+int main()
+{
+    constexpr int PROGRAMS = 50;
+    constexpr int EDITS = 40;
+    int failed = 0;
+    std::mt19937 random(14);
+    for (int programId = 0; programId < PROGRAMS; ++programId)
+    {
+        cli::PeachCli cli;
+        auto program = cli.makeIncrementalProgram();
+        auto symbols = cli.getScope().getSymbolTable();
+        std::string text = makeText(random, 20);
+        program.setText(text);
+        for (int edit = 0; edit <= EDITS; ++edit)
+        {
+            std::string incremental = run([&] { return program.getProgram(); }, symbols);
+            cli::PeachCli rebuildCli;
+            std::string rebuild = run([&] { return rebuildCli.interpretateProgram(text); }, rebuildCli.getScope().getSymbolTable());
+            if (program.getText() != text || incremental != rebuild)
+            {
+                ++failed;
+                std::cerr << "program " << programId << " failed after " << edit << " edits\n"
+                          << text << "rebuild: " << rebuild << "\nincremental: " << incremental << '\n';
+                break;
+            }
+
+            // Replaces random lines [first, last) with random ones
+            std::vector<std::string> lines;
+            for (std::size_t begin = 0; begin < text.size();)
+            {
+                std::size_t end = text.find('\n', begin);
+                lines.push_back(text.substr(begin, end + 1 - begin));
+                begin = end + 1;
+            }
+            std::size_t first = random() % (lines.size() + 1);
+            std::size_t last = first + random() % (std::min<std::size_t>(lines.size() - first, 4) + 1);
+            std::string newText = makeText(random, 4);
+            program.edit(first, last, newText);
+            lines.erase(lines.begin() + first, lines.begin() + last);
+            text.clear();
+            for (std::size_t line = 0; line < lines.size(); ++line)
+            {
+                if (line == first)
+                {
+                    text += newText;
+                }
+                text += lines[line];
+            }
+            if (first == lines.size())
+            {
+                text += newText;
+            }
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FsmCollection.hpp"
+#include "PeachCli.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+using namespace peach;
+
+// Collection of FSMs, which are lowered at runtime, unlike static tables of cli
+// Peach has no strings, so string literals are lexed as COLON tokens
+std::shared_ptr<const fsm::Lexer> makeLiteralLexer()
+{
+    fsm::FsmCollection collection;
+    collection.buildAppendFsm<fsm::NameFinder>()
+        .buildAppendFsm<fsm::NumberFinder>(token::tokenCategory::VALUE_INT)
+        .buildAppendFsm<fsm::LiteralFinder<'"'>>(token::tokenCategory::COLON)
+        .buildAppendFsm<fsm::OperatorFinder>(std::vector<std::pair<std::string, token::tokenCategory_t>>{
+            {"+", token::tokenCategory::OPERATOR_BI},
+            {"+=", token::tokenCategory::ASSIGNMENT},
+            {"=", token::tokenCategory::ASSIGNMENT},
+        })
+        .buildAppendFsm<fsm::SingleCharFinder>(std::vector<std::pair<char, token::tokenCategory_t>>{
+            {'\n', token::tokenCategory::SEP_ENDL},
+            {' ', token::tokenCategory::SEP_SPACE},
+            {'\t', token::tokenCategory::SEP_TAB},
+        })
+        .setKeywords(cli::PeachCli::KEYWORDS)
+        .setIndentation({token::tokenCategory::SEP_TAB});
+    return collection.getLexer();
+}
+
+// Returns random text of lines with indentation, names, keywords, numbers, literals and undefined characters
+// Literals and undefined tokens may contain line ends, so chunks may begin inside of them
+std::string makeText(std::mt19937 &random)
+{
+    const std::vector<std::string> words = {"a", "b1", "if", "else", "while", "let", "_x", "12", "3.5", "+", "+=", "=",
+                                            "**", "(", ")", "\"s\"", "\"a b\n c\"", "\"", "$", "  ", "\t", " "};
+    std::string text;
+    for (std::size_t lines = random() % 60; lines > 0; --lines)
+    {
+        text += std::string(random() % 4, '\t');
+        for (std::size_t count = random() % 8; count > 0; --count)
+        {
+            text += words[random() % words.size()];
+            text += random() % 3 == 0 ? "" : " ";
+        }
+        text += '\n';
+    }
+    return random() % 4 == 0 ? text.substr(0, text.size() / 2) : text;
+}
+
+// Returns description of the first difference of tokens and symbols, empty string if they are equal
+std::string compare(const token::TokenBuffer &expected,
+                    const token::SymbolTable &expectedSymbols,
+                    const token::TokenBuffer &tokens,
+                    const token::SymbolTable &symbols)
+{
+    if (tokens.size() != expected.size())
+    {
+        return std::to_string(tokens.size()) + " tokens instead of " + std::to_string(expected.size());
+    }
+    for (std::size_t id = 0; id < tokens.size(); ++id)
+    {
+        const auto *literal = tokens.getLiteral(id);
+        const auto *expectedLiteral = expected.getLiteral(id);
+        if (tokens.getCategory(id) != expected.getCategory(id) || tokens.getTokenString(id) != expected.getTokenString(id) ||
+            tokens.getTextPosition(id) != expected.getTextPosition(id) || tokens.getLine(id) != expected.getLine(id) ||
+            tokens.getLinePosition(id) != expected.getLinePosition(id) || tokens.getSymbol(id) != expected.getSymbol(id) ||
+            (literal == nullptr) != (expectedLiteral == nullptr) || (literal && *literal != *expectedLiteral))
+        {
+            return "token " + std::to_string(id) + " '" + std::string(tokens.getTokenString(id)) + "' differs";
+        }
+    }
+    if (symbols.size() != expectedSymbols.size())
+    {
+        return std::to_string(symbols.size()) + " symbols instead of " + std::to_string(expectedSymbols.size());
+    }
+    for (token::symbol_t symbol = 0; symbol < symbols.size(); ++symbol)
+    {
+        if (symbols.getName(symbol) != expectedSymbols.getName(symbol))
+        {
+            return "symbol " + std::to_string(symbol) + " differs";
+        }
+    }
+    return "";
+}
+} // namespace
+
+// Tokenizes random texts by pool workers with chunks of a few chars, tokens and symbols must be the same,
+// as serial tokenization gives
+int main()
+{
+    constexpr int TEXTS = 300;
+    int failed = 0;
+    std::mt19937 random(8);
+    tools::ThreadPool pool(4);
+    cli::PeachCli cli;
+    const std::vector<std::shared_ptr<const fsm::Lexer>> lexers = {cli.getLexer(), makeLiteralLexer()};
+    for (int textId = 0; textId < TEXTS; ++textId)
+    {
+        std::string text = makeText(random);
+        for (const auto &lexer : lexers)
+        {
+            token::SymbolTable expectedSymbols;
+            auto expected = lexer->tokenize(text, &expectedSymbols);
+            for (std::size_t minChunkSize : {1, 2, 5, 16})
+            {
+                token::SymbolTable symbols;
+                auto tokens = lexer->tokenize(text, pool, &symbols, minChunkSize);
+                std::string difference = compare(expected, expectedSymbols, tokens, symbols);
+                if (!difference.empty())
+                {
+                    ++failed;
+                    std::cerr << "text " << textId << " failed with chunks of " << minChunkSize << " chars: " << difference << '\n'
+                              << text << '\n';
+                }
+            }
+        }
+    }
+    return failed;
+}
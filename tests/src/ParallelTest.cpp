@@ -0,0 +1,142 @@
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "PeachCli.hpp"
+#include "ThreadPool.hpp"
+
+namespace
+{
+using namespace peach;
+
+interpreter::Interpreter makeInterpreter()
+{
+    using expression::PeachTuple;
+    using expression::VType;
+    interpreter::Interpreter interpreter(
+        {token::tokenCategory::SEP_TAB},
+        {
+            {[](PeachTuple args) { return VType(args[0] * args[1]); }, "*", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] + args[1]); }, "+", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] - args[1]); }, "-", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] < args[1]); }, "<", token::tokenCategory::OPERATOR_BI},
+            {[](PeachTuple args) { return VType(args[0] > args[1]); }, ">", token::tokenCategory::OPERATOR_BI},
+        },
+        {
+            {[](VType &left, VType right) { left = right; }, "=", token::tokenCategory::ASSIGNMENT},
+            {[](VType &left, VType right) { left += right; }, "+=", token::tokenCategory::ASSIGNMENT},
+            {[](VType &left, VType right) { left -= right; }, "-=", token::tokenCategory::ASSIGNMENT},
+        });
+    interpreter.setOperatorPatterns(cli::PeachCli::OPERATORS);
+    return interpreter;
+}
+
+// Returns random program with nested blocks, loops, declarations and rare broken lines
+std::string makeProgram(std::mt19937 &random)
+{
+    const std::vector<std::string> broken = {"b = (1", "b = ? 1", "b = 1 +", "  x $ y", "let 4", "else", "let a"};
+    std::string text = "let a = 1\nlet b = 2\nlet w = 0\n";
+    std::string blocks;  // kinds of open blocks: 'i' for 'if', 'e' for 'else', 'w' for 'while'
+    bool opened = false; // previous line opens block, so this one must be deeper
+    for (std::size_t count = 5 + random() % 80; count > 0; --count)
+    {
+        std::size_t tabs = opened ? blocks.size() : random() % (blocks.size() + 1);
+        std::string indentation(tabs, '\t');
+        char closed = tabs < blocks.size() ? blocks[tabs] : ' ';
+        blocks.resize(tabs);
+        opened = false;
+        switch (random() % 8)
+        {
+        case 0:
+            text += indentation + "if a > " + std::to_string(random() % 7) + '\n';
+            blocks += 'i';
+            opened = true;
+            break;
+        case 1:
+            if (closed == 'i')
+            {
+                text += indentation + "else\n";
+                blocks += 'e';
+                opened = true;
+                break;
+            }
+            [[fallthrough]];
+        case 2:
+            text += indentation + "w = 0\n" + indentation + "while w < 3\n" + indentation + "\tw += 1\n";
+            blocks += 'w';
+            break;
+        case 3:
+            if (blocks.find('w') == std::string::npos)
+            {
+                text += indentation + "let c" + std::to_string(count) + " = a\n";
+                break;
+            }
+            [[fallthrough]];
+        default:
+            text += indentation + "b = b * 2 - a + " + std::to_string(random() % 9) + '\n';
+            text += indentation + "a += " + std::to_string(random() % 3) + '\n';
+            break;
+        }
+        if (random() % 100 == 0)
+        {
+            text += std::string(blocks.size() + random() % 2, '\t') + broken[random() % broken.size()] + '\n';
+            opened = false;
+        }
+    }
+    return text + "b\n";
+}
+
+// Interpretates tokens of program, returns value or error of program and number of its symbols
+// Names are interned by lexer or by interpreter, if lexSymbols is false
+std::string run(const std::string &text,
+                bool lexSymbols,
+                const std::function<void(interpreter::Interpreter &, const token::TokenBuffer &)> &interpretate)
+{
+    cli::PeachCli cli;
+    auto interpreter = makeInterpreter();
+    auto tokens = cli.getLexer()->tokenize(text, lexSymbols ? interpreter.getSymbolTable().get() : nullptr);
+    try
+    {
+        interpretate(interpreter, tokens);
+        expression::Scope scope(interpreter.getSymbolTable());
+        return std::to_string(interpreter.getInterpretationResult()->eval(scope)) + " symbols " +
+               std::to_string(interpreter.getSymbolTable()->size());
+    }
+    catch (const std::exception &e)
+    {
+        return e.what();
+    }
+}
+} // namespace
+
+// Interpretates random programs by pool workers with small chunks, results and errors must be the same,
+// as serial interpretation gives
+int main()
+{
+    constexpr int PROGRAMS = 300;
+    int failed = 0;
+    std::mt19937 random(17);
+    tools::ThreadPool pool(4);
+    for (int programId = 0; programId < PROGRAMS; ++programId)
+    {
+        std::string text = makeProgram(random);
+        std::size_t minChunkTokens = 1 + random() % 40;
+        bool lexSymbols = programId % 2 == 0;
+        std::string serial = run(text, lexSymbols, [](interpreter::Interpreter &interpreter, const token::TokenBuffer &tokens) {
+            interpreter.interpretateLines(tokens.begin(), tokens.end());
+        });
+        std::string parallel = run(text, lexSymbols, [&](interpreter::Interpreter &interpreter, const token::TokenBuffer &tokens) {
+            interpreter.interpretateLines(tokens.begin(), tokens.end(), pool, 0, minChunkTokens);
+        });
+        if (parallel != serial)
+        {
+            ++failed;
+            std::cerr << "program " << programId << " failed with chunks of " << minChunkTokens << " tokens\n"
+                      << text << "serial: " << serial << "\nparallel: " << parallel << '\n';
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "PeachCli.hpp"
+
+namespace
+{
+// Input of command line interface and its expected output
+struct ReplCase
+{
+    std::string name;
+    std::string input;
+    std::string output;
+};
+
+// Broken lines must not leave levels in interpreter, next lines are interpretated like they were not written
+const std::vector<ReplCase> CASES = {
+    {"too deep lines",
+     "let a = 1\n\ta = 2\n\ta = 3\na\n",
+     "Peach\n"
+     ">>> 1\n"
+     ">>> IndentationError: bad indentation at 0:1\n"
+     ">>> IndentationError: bad indentation at 0:1\n"
+     ">>> 1\n"
+     ">>> 0\n"},
+    {"else without if",
+     "else\n1\n",
+     "Peach\n"
+     ">>> UnexpectedElseError: can not process 'else' if it not preceded by 'if' at 0:0\n"
+     ">>> 1\n"
+     ">>> 0\n"},
+    {"broken headers",
+     "if (\n2\nwhile 1 +\n3\n",
+     "Peach\n"
+     ">>> BracketDisbalanceError: can't match bracket at 0:3\n"
+     ">>> 2\n"
+     ">>> SyntaxError: invalid syntax at 0:8\n"
+     ">>> 3\n"
+     ">>> 0\n"},
+    {"conditional",
+     "let b = 0\nif b == 0\n\tb = 5\nelse\n\tb = 6\n\nb\n",
+     "Peach\n"
+     ">>> 0\n"
+     ">>> ... ... ... ... 5\n"
+     ">>> 5\n"
+     ">>> 0\n"},
+};
+} // namespace
+
+// Runs command line interface loop on inputs, returns number of failed cases
+int main()
+{
+    int failed = 0;
+    for (const auto &replCase : CASES)
+    {
+        peach::cli::PeachCli cli;
+        std::istringstream is(replCase.input);
+        std::ostringstream os;
+        cli.loop(is, os);
+        if (os.str() != replCase.output)
+        {
+            ++failed;
+            std::cerr << replCase.name << " failed, expected:\n"
+                      << replCase.output << "got:\n"
+                      << os.str();
+        }
+    }
+    return failed;
+}